@@ -0,0 +1,42 @@
+#!/bin/bash
+# Mesure le temps de chargement d'une configuration générée de N blocs server (1000 par défaut) via "webserv -t"
+
+SERVERS=${1:-1000}
+RUNS=${2:-5}
+WEBSERV=${WEBSERV:-./webserv}
+CONF=$(mktemp /tmp/webserv-bench-XXXXXX.conf)
+
+trap 'rm -f "$CONF"' EXIT
+
+for ((i = 0; i < SERVERS; i++)); do
+    cat >> "$CONF" <<BLOCK
+server {
+    host: 127.0.0.1
+    port: $((20000 + i % 500))
+    server_name: site$i.example.com www.site$i.example.com
+    error_page: 404 /errors/404.html
+    client_max_body_size: 2m
+    root: www
+    index: index.html
+    allowed_methods: GET, POST
+    denied_methods: DELETE
+    cgi_bin: /cgi-bin
+    cgi_ext: .cgi, .pl, .php, .py
+    cgi_handler:
+        .pl: /usr/bin/perl
+        .php: /usr/bin/php
+        .py: /usr/bin/python3
+    redirection: /old$i.html /new$i.html
+    directory_listing: off;
+    location /static/ {
+        directory_listing: on
+    }
+}
+
+BLOCK
+done
+
+echo "Configuration de $SERVERS blocs server : $(wc -l < "$CONF") lignes"
+for ((run = 1; run <= RUNS; run++)); do
+    "$WEBSERV" -t "$CONF" 2>&1 | tail -n 1
+done
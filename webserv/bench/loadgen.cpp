@@ -0,0 +1,410 @@
+// Générateur de charge HTTP/1.1 de "make bench" : N connexions non bloquantes pilotées par epoll.
+// Toutes les latences sont conservées pour des centiles exacts ; le résultat tient sur une ligne JSON (stdout)
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+struct Options
+{
+    std::string     name;
+    std::string     host;
+    std::string     port;
+    std::string     method;
+    std::string     path;
+    int             concurrency;
+    double          duration;
+    bool            keepAlive;
+    int             depth;
+    size_t          bodySize;
+    int             expected;
+
+    Options() : name("bench"), host("127.0.0.1"), port("8180"), method("GET"), path("/"), concurrency(32), duration(5),
+        keepAlive(false), depth(1), bodySize(0), expected(0)
+    {
+    }
+};
+
+struct Client
+{
+    int                 fd;
+    bool                connecting;
+    std::string         batch;
+    size_t              sent;
+    std::string         input;
+    std::vector<long>   sentAt;
+    size_t              answered;
+    bool                serverCloses;
+
+    Client() : fd(-1), connecting(false), sent(0), answered(0), serverCloses(false)
+    {
+    }
+};
+
+struct Results
+{
+    unsigned long       completed;
+    unsigned long       errors;
+    unsigned long       unexpected;
+    unsigned long       connections;
+    unsigned long long  bytes;
+    std::vector<long>   latencies;
+
+    Results() : completed(0), errors(0), unexpected(0), connections(0), bytes(0)
+    {
+    }
+};
+
+static Options              options;
+static Results              results;
+static std::vector<Client>  clients;
+static struct addrinfo*     address = NULL;
+static int                  epollFd = -1;
+
+static long monotonicMicros()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000L + now.tv_nsec / 1000;
+}
+
+static void usage(const char* program)
+{
+    std::fprintf(stderr, "Usage: %s [-n nom] [-c connexions] [-d secondes] [-k] [-P profondeur] [-m méthode] [-b octets]"
+        " [-e statut] hôte:port chemin\n  %%d dans le chemin est remplacé par le numéro de connexion\n", program);
+    std::exit(2);
+}
+
+// Un lot de "depth" requêtes identiques, envoyé d'un seul tenant (pipelining quand depth > 1)
+static std::string buildBatch(size_t index)
+{
+    std::string path = options.path;
+    std::string::size_type marker = path.find("%d");
+    if (marker != std::string::npos)
+    {
+        char number[16];
+        std::sprintf(number, "%lu", static_cast<unsigned long>(index));
+        path.replace(marker, 2, number);
+    }
+
+    std::string request = options.method + " " + path + " HTTP/1.1\r\nHost: " + options.host + ":" + options.port
+        + "\r\nUser-Agent: webserv-loadgen\r\nConnection: " + (options.keepAlive ? "keep-alive" : "close") + "\r\n";
+    if (options.bodySize > 0)
+    {
+        char length[32];
+        std::sprintf(length, "%lu", static_cast<unsigned long>(options.bodySize));
+        request += std::string("Content-Type: application/octet-stream\r\nContent-Length: ") + length + "\r\n";
+    }
+    request += "\r\n";
+    request.append(options.bodySize, 'x');
+
+    std::string batch;
+    for (int i = 0; i < options.depth; ++i)
+    {
+        batch += request;
+    }
+    return batch;
+}
+
+static void startBatch(Client& client, size_t index)
+{
+    long now = monotonicMicros();
+    client.batch = buildBatch(index);
+    client.sent = 0;
+    client.answered = 0;
+    client.sentAt.assign(options.depth, now);
+
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.u32 = static_cast<unsigned int>(index);
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &event);
+}
+
+static void openClient(size_t index)
+{
+    Client& client = clients[index];
+    client.input.clear();
+    client.serverCloses = false;
+    client.fd = socket(address->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (client.fd < 0)
+    {
+        std::perror("socket");
+        std::exit(1);
+    }
+    int on = 1;
+    setsockopt(client.fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    if (connect(client.fd, address->ai_addr, address->ai_addrlen) < 0 && errno != EINPROGRESS)
+    {
+        std::perror("connect");
+        std::exit(1);
+    }
+    client.connecting = true;
+    ++results.connections;
+
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.u32 = static_cast<unsigned int>(index);
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, client.fd, &event);
+    startBatch(client, index);
+}
+
+static void reopenClient(size_t index)
+{
+    close(clients[index].fd);
+    clients[index].fd = -1;
+    openClient(index);
+}
+
+static void failClient(size_t index)
+{
+    ++results.errors;
+    reopenClient(index);
+}
+
+static void sendPending(size_t index)
+{
+    Client& client = clients[index];
+    while (client.sent < client.batch.size())
+    {
+        ssize_t written = send(client.fd, client.batch.data() + client.sent, client.batch.size() - client.sent, MSG_NOSIGNAL);
+        if (written < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return;
+            }
+            failClient(index);
+            return;
+        }
+        client.sent += written;
+    }
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u32 = static_cast<unsigned int>(index);
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &event);
+}
+
+// Longueur de la réponse en tête du tampon, 0 si elle est incomplète ; -1 sans Content-Length (corps jusqu'à la fermeture)
+static long responseLength(Client& client, int& status)
+{
+    std::string::size_type headerEnd = client.input.find("\r\n\r\n");
+    if (headerEnd == std::string::npos)
+    {
+        return 0;
+    }
+    status = std::atoi(client.input.c_str() + 9);
+
+    long contentLength = -1;
+    std::string::size_type lineStart = client.input.find("\r\n") + 2;
+    while (lineStart < headerEnd)
+    {
+        std::string::size_type lineEnd = client.input.find("\r\n", lineStart);
+        const char* line = client.input.c_str() + lineStart;
+        if (strncasecmp(line, "Content-Length:", 15) == 0)
+        {
+            contentLength = std::atol(line + 15);
+        }
+        else if (strncasecmp(line, "Connection:", 11) == 0 && client.input.compare(lineStart + 11, 6, " close") == 0)
+        {
+            client.serverCloses = true;
+        }
+        lineStart = lineEnd + 2;
+    }
+
+    if (contentLength < 0)
+    {
+        return -1;
+    }
+    size_t total = headerEnd + 4 + contentLength;
+    return client.input.size() >= total ? static_cast<long>(total) : 0;
+}
+
+static void completeResponse(size_t index, int status, size_t length)
+{
+    Client& client = clients[index];
+    results.latencies.push_back(monotonicMicros() - client.sentAt[client.answered]);
+    results.bytes += length;
+    ++results.completed;
+    ++client.answered;
+    if (options.expected ? status != options.expected : (status < 200 || status >= 300))
+    {
+        ++results.unexpected;
+    }
+    client.input.erase(0, length);
+}
+
+static void receive(size_t index)
+{
+    Client& client = clients[index];
+    char buffer[65536];
+    ssize_t received = recv(client.fd, buffer, sizeof(buffer), 0);
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+        return;
+    }
+    if (received <= 0)
+    {
+        int status = 0;
+        if (received == 0 && responseLength(client, status) < 0 && client.answered + 1 == client.sentAt.size())
+        {
+            completeResponse(index, status, client.input.size());
+            reopenClient(index);
+            return;
+        }
+        failClient(index);
+        return;
+    }
+    client.input.append(buffer, received);
+
+    int status = 0;
+    long length;
+    while (client.answered < client.sentAt.size() && (length = responseLength(client, status)) > 0)
+    {
+        completeResponse(index, status, static_cast<size_t>(length));
+    }
+    if (client.answered < client.sentAt.size())
+    {
+        return;
+    }
+    if (options.keepAlive && !client.serverCloses)
+        startBatch(client, index);
+    else
+        reopenClient(index);
+}
+
+static long percentile(double fraction)
+{
+    if (results.latencies.empty())
+    {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(fraction * results.latencies.size());
+    return results.latencies[std::min(rank, results.latencies.size() - 1)];
+}
+
+static void parseArguments(int argc, char** argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "n:c:d:kP:m:b:e:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': options.name = optarg; break;
+            case 'c': options.concurrency = std::atoi(optarg); break;
+            case 'd': options.duration = std::atof(optarg); break;
+            case 'k': options.keepAlive = true; break;
+            case 'P': options.depth = std::atoi(optarg); break;
+            case 'm': options.method = optarg; break;
+            case 'b': options.bodySize = std::strtoul(optarg, NULL, 10); break;
+            case 'e': options.expected = std::atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (argc - optind != 2 || options.concurrency <= 0 || options.depth <= 0 || options.duration <= 0)
+    {
+        usage(argv[0]);
+    }
+
+    std::string target = argv[optind];
+    std::string::size_type colon = target.rfind(':');
+    if (colon == std::string::npos)
+    {
+        usage(argv[0]);
+    }
+    options.host = target.substr(0, colon);
+    options.port = target.substr(colon + 1);
+    options.path = argv[optind + 1];
+    if (options.depth > 1)
+    {
+        options.keepAlive = true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    parseArguments(argc, argv);
+    signal(SIGPIPE, SIG_IGN);
+
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_socktype = SOCK_STREAM;
+    int error = getaddrinfo(options.host.c_str(), options.port.c_str(), &hints, &address);
+    if (error != 0)
+    {
+        std::fprintf(stderr, "%s:%s : %s\n", options.host.c_str(), options.port.c_str(), gai_strerror(error));
+        return 1;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    clients.resize(options.concurrency);
+    results.latencies.reserve(1 << 20);
+
+    long start = monotonicMicros();
+    long deadline = start + static_cast<long>(options.duration * 1e6);
+    for (size_t i = 0; i < clients.size(); ++i)
+    {
+        openClient(i);
+    }
+
+    struct epoll_event events[256];
+    while (monotonicMicros() < deadline)
+    {
+        int count = epoll_wait(epollFd, events, 256, 100);
+        for (int i = 0; i < count; ++i)
+        {
+            size_t index = events[i].data.u32;
+            Client& client = clients[index];
+            if (client.connecting && (events[i].events & (EPOLLOUT | EPOLLERR)))
+            {
+                int socketError = 0;
+                socklen_t length = sizeof(socketError);
+                getsockopt(client.fd, SOL_SOCKET, SO_ERROR, &socketError, &length);
+                if (socketError != 0)
+                {
+                    failClient(index);
+                    continue;
+                }
+                client.connecting = false;
+            }
+            if ((events[i].events & EPOLLOUT) && client.sent < client.batch.size())
+            {
+                sendPending(index);
+            }
+            else if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            {
+                receive(index);
+            }
+        }
+    }
+    double elapsed = (monotonicMicros() - start) / 1e6;
+
+    std::sort(results.latencies.begin(), results.latencies.end());
+    std::printf("{\"workload\":\"%s\",\"method\":\"%s\",\"path\":\"%s\",\"concurrency\":%d,\"keepalive\":%s,\"pipeline\":%d,"
+        "\"body_bytes\":%lu,\"duration_s\":%.3f,\"requests\":%lu,\"errors\":%lu,\"unexpected_status\":%lu,\"connections\":%lu,"
+        "\"throughput_rps\":%.1f,\"transfer_bytes\":%llu,\"latency_us\":{\"p50\":%ld,\"p99\":%ld,\"p999\":%ld,\"max\":%ld}}\n",
+        options.name.c_str(), options.method.c_str(), options.path.c_str(), options.concurrency, options.keepAlive ? "true" : "false",
+        options.depth, static_cast<unsigned long>(options.bodySize), elapsed, results.completed, results.errors, results.unexpected,
+        results.connections, results.completed / elapsed, results.bytes, percentile(0.50), percentile(0.99), percentile(0.999),
+        results.latencies.empty() ? 0L : results.latencies.back());
+    std::fprintf(stderr, "%-10s %8lu requêtes %10.1f req/s  p50 %6ld us  p99 %7ld us  p999 %7ld us  erreurs %lu  statut inattendu %lu\n",
+        options.name.c_str(), results.completed, results.completed / elapsed, percentile(0.50), percentile(0.99),
+        percentile(0.999), results.errors, results.unexpected);
+
+    freeaddrinfo(address);
+    return 0;
+}
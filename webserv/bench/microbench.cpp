@@ -0,0 +1,310 @@
+// Microbenchmarks de "make microbench" : coût CPU par appel des chemins chauds du traitement d'une requête,
+// sur un corpus fixe de requêtes réalistes. Le journal est réglé sur ERROR pour mesurer le code et non le Logger.
+// Tableau lisible sur stderr, une ligne JSON par cas sur stdout
+
+#include "RequestHandler.hpp"
+#include "Response.hpp"
+#include "Cookies.hpp"
+#include "MultipartParser.hpp"
+#include "Logger.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <dirent.h>
+#include <unistd.h>
+
+static const char* BROWSER_GET =
+    "GET /images/photo-gallery/summer.jpg?size=large&v=3 HTTP/1.1\r\n"
+    "Host: localhost:3000\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0\r\n"
+    "Accept: image/avif,image/webp,image/png,image/svg+xml,image/*;q=0.8,*/*;q=0.5\r\n"
+    "Accept-Language: fr-FR,fr;q=0.8,en-US;q=0.5,en;q=0.3\r\n"
+    "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+    "Referer: http://localhost:3000/proxygirls.html\r\n"
+    "Connection: keep-alive\r\n"
+    "Cookie: sessionId=5f2b9c1e7a3d4e8f9a0b1c2d3e4f5a6b; theme=dark; lang=fr; _ga=GA1.1.123456789.1700000000\r\n"
+    "Sec-Fetch-Dest: image\r\n"
+    "Sec-Fetch-Mode: no-cors\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Priority: u=5, i\r\n"
+    "\r\n";
+
+static const char* CURL_GET =
+    "GET /proxygirls.html HTTP/1.1\r\n"
+    "Host: localhost:3000\r\n"
+    "User-Agent: curl/8.5.0\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+static const char* FORM_POST =
+    "POST /cgi-bin/cgi.py HTTP/1.1\r\n"
+    "Host: localhost:4200\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Content-Type: application/x-www-form-urlencoded\r\n"
+    "Content-Length: 58\r\n"
+    "Origin: http://localhost:4200\r\n"
+    "Connection: keep-alive\r\n"
+    "Cookie: sessionId=5f2b9c1e7a3d4e8f9a0b1c2d3e4f5a6b\r\n"
+    "\r\n"
+    "name=Jean+Dupont&email=jean%40example.fr&message=Bonjour%21";
+
+static const char* MULTIPART_HEADERS =
+    "POST /upload HTTP/1.1\r\n"
+    "Host: localhost:3500\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Content-Type: multipart/form-data; boundary=----geckoformboundary7d5a9c3e1f\r\n"
+    "Content-Length: 65790\r\n"
+    "Origin: http://localhost:3500\r\n"
+    "Connection: keep-alive\r\n"
+    "Referer: http://localhost:3500/pages.html\r\n"
+    "\r\n";
+
+static volatile size_t sink;
+
+struct Case
+{
+    std::string name;
+    double      nanoseconds;
+    long        iterations;
+};
+
+static std::vector<Case> cases;
+
+static long nowNanos()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+// Double le nombre d'itérations jusqu'à dépasser 200 ms de mesure, après un tour de chauffe
+template <typename Body>
+static void measure(const std::string& name, Body body)
+{
+    body(100);
+    long iterations = 100;
+    long elapsed = 0;
+    while (true)
+    {
+        long start = nowNanos();
+        body(iterations);
+        elapsed = nowNanos() - start;
+        if (elapsed >= 200000000L || iterations >= (1L << 30))
+        {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    Case result;
+    result.name = name;
+    result.nanoseconds = static_cast<double>(elapsed) / iterations;
+    result.iterations = iterations;
+    cases.push_back(result);
+    std::fprintf(stderr, "%-34s %12.1f ns/op %12ld itérations\n", name.c_str(), result.nanoseconds, iterations);
+}
+
+struct ParseRequest
+{
+    RequestHandler* handler;
+    std::string     text;
+
+    void operator()(long iterations) const
+    {
+        for (long i = 0; i < iterations; ++i)
+        {
+            sink += handler->parseRequest(text).headers.size();
+        }
+    }
+};
+
+struct UrlDecode
+{
+    RequestHandler* handler;
+
+    void operator()(long iterations) const
+    {
+        std::string encoded = "/recherche?q=caf%C3%A9+cr%C3%A8me&lang=fr%2Dfr&filtre=prix%3C20%E2%82%AC&page=2";
+        for (long i = 0; i < iterations; ++i)
+        {
+            sink += handler->urlDecode(encoded).size();
+        }
+    }
+};
+
+struct NormalizePath
+{
+    RequestHandler* handler;
+
+    void operator()(long iterations) const
+    {
+        std::string path = "www/./images/../fichiers/./archives/2024/../2025/FormulaireBasique.pdf";
+        for (long i = 0; i < iterations; ++i)
+        {
+            sink += handler->normalizePath(path).size();
+        }
+    }
+};
+
+struct DetermineMimeType
+{
+    RequestHandler*             handler;
+    std::vector<std::string>    paths;
+
+    void operator()(long iterations) const
+    {
+        for (long i = 0; i < iterations; ++i)
+        {
+            sink += handler->determineMimeType(paths[i % paths.size()]).size();
+        }
+    }
+};
+
+struct ExtractCookies
+{
+    std::string text;
+
+    void operator()(long iterations) const
+    {
+        for (long i = 0; i < iterations; ++i)
+        {
+            Cookies cookies;
+            cookies.extractCookiesFromRequest(text);
+            sink += cookies.getCookies().size();
+        }
+    }
+};
+
+struct BuildResponse
+{
+    HttpResponse response;
+
+    void operator()(long iterations) const
+    {
+        for (long i = 0; i < iterations; ++i)
+        {
+            sink += Response::buildHttpResponse(response).size();
+        }
+    }
+};
+
+// Corps de deux parties (un champ, un fichier de 64 Kio) découpé en lectures de 4 Kio comme le fait readFromClient
+struct ParseMultipart
+{
+    std::string body;
+    std::string uploadDir;
+
+    void operator()(long iterations) const
+    {
+        for (long i = 0; i < iterations; ++i)
+        {
+            MultipartParser parser("----geckoformboundary7d5a9c3e1f", uploadDir);
+            for (size_t offset = 0; offset < body.size(); offset += 4096)
+            {
+                parser.feed(body.data() + offset, std::min(static_cast<size_t>(4096), body.size() - offset));
+            }
+            sink += parser.getFiles().size();
+        }
+    }
+};
+
+static std::string buildMultipartBody()
+{
+    std::string body = "------geckoformboundary7d5a9c3e1f\r\n"
+        "Content-Disposition: form-data; name=\"description\"\r\n\r\n"
+        "Photos de vacances\r\n"
+        "------geckoformboundary7d5a9c3e1f\r\n"
+        "Content-Disposition: form-data; name=\"fichier\"; filename=\"vacances.bin\"\r\n"
+        "Content-Type: application/octet-stream\r\n\r\n";
+    for (size_t i = 0; i < 65536; ++i)
+    {
+        body += static_cast<char>('a' + (i * 7) % 26);
+    }
+    body += "\r\n------geckoformboundary7d5a9c3e1f--\r\n";
+    return body;
+}
+
+static void removeDirectory(const std::string& path)
+{
+    DIR* dir = opendir(path.c_str());
+    if (dir)
+    {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL)
+        {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..")
+            {
+                unlink((path + "/" + name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(path.c_str());
+}
+
+int main()
+{
+    Logger::getInstance().configure("/dev/null", Logger::ERROR, Logger::ERROR);
+    RequestHandler handler;
+
+    const char* corpus[][2] = {
+        { "parseRequest/browser_get", BROWSER_GET },
+        { "parseRequest/curl_get", CURL_GET },
+        { "parseRequest/form_post", FORM_POST },
+        { "parseRequest/multipart_headers", MULTIPART_HEADERS }
+    };
+    for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); ++i)
+    {
+        ParseRequest parse = { &handler, corpus[i][1] };
+        measure(corpus[i][0], parse);
+    }
+
+    UrlDecode decode = { &handler };
+    measure("urlDecode", decode);
+
+    NormalizePath normalize = { &handler };
+    measure("normalizePath", normalize);
+
+    DetermineMimeType mime;
+    mime.handler = &handler;
+    mime.paths.push_back("www/proxygirls.html");
+    mime.paths.push_back("www/style.css");
+    mime.paths.push_back("www/images/logo.png");
+    mime.paths.push_back("www/fichiers/FormulaireBasique.pdf");
+    mime.paths.push_back("www/AmsterdamThree.ttf");
+    measure("determineMimeType", mime);
+
+    ExtractCookies cookies = { BROWSER_GET };
+    measure("Cookies::extractCookiesFromRequest", cookies);
+
+    BuildResponse build;
+    build.response.httpVersion = "HTTP/1.1";
+    build.response.statusCode = 200;
+    build.response.statusMessage = "OK";
+    build.response.body.assign(6700, 'x');
+    build.response.headers["Content-Type"] = "text/html; charset=utf-8";
+    build.response.headers["Set-Cookie"] = "sessionId=5f2b9c1e7a3d4e8f9a0b1c2d3e4f5a6b; Path=/; Max-Age=3600";
+    measure("Response::buildHttpResponse", build);
+
+    char uploadDir[] = "/tmp/webserv-microbench-XXXXXX";
+    if (mkdtemp(uploadDir))
+    {
+        ParseMultipart multipart = { buildMultipartBody(), uploadDir };
+        measure("MultipartParser::feed/64k_file", multipart);
+        removeDirectory(uploadDir);
+    }
+
+    for (size_t i = 0; i < cases.size(); ++i)
+    {
+        std::printf("{\"case\":\"%s\",\"ns_per_op\":%.1f,\"iterations\":%ld}\n",
+            cases[i].name.c_str(), cases[i].nanoseconds, cases[i].iterations);
+    }
+    Logger::getInstance().cleanup();
+    return 0;
+}
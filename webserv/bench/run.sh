@@ -0,0 +1,43 @@
+#!/bin/bash
+# Lance webserv avec bench/bench.conf sur la boucle locale puis enchaîne les charges de travail avec bench/loadgen ;
+# une ligne JSON par charge dans $BENCH_OUTPUT, suivie des métriques du serveur dans $BENCH_OUTPUT.metrics
+
+CONCURRENCY=${BENCH_CONCURRENCY:-32}
+DURATION=${BENCH_DURATION:-5}
+OUTPUT=${BENCH_OUTPUT:-bench_results.json}
+WEBSERV=${WEBSERV:-./webserv}
+LOADGEN=${LOADGEN:-./bench/loadgen}
+ADDRESS=127.0.0.1:8180
+
+"$WEBSERV" bench/bench.conf > /dev/null 2>&1 &
+PID=$!
+trap 'kill -INT $PID 2>/dev/null; wait $PID 2>/dev/null; rm -f uploads/bench-*.bin; rmdir uploads 2>/dev/null' EXIT
+
+for ((i = 0; i < 50; i++)); do
+    (exec 3<>/dev/tcp/127.0.0.1/8180) 2>/dev/null && break
+    sleep 0.1
+done
+if ! kill -0 $PID 2>/dev/null; then
+    echo "webserv n'a pas démarré (voir server.log)" >&2
+    exit 1
+fi
+
+run()
+{
+    "$LOADGEN" -c "$CONCURRENCY" -d "$DURATION" "$@" >> "$OUTPUT" || exit 1
+}
+
+: > "$OUTPUT"
+echo "$CONCURRENCY connexions, $DURATION s par charge"
+run -n static $ADDRESS /proxygirls.html
+run -n keepalive -k $ADDRESS /proxygirls.html
+run -n pipelined -k -P 8 $ADDRESS /style.css
+run -n cgi -k $ADDRESS /cgi-bin/cgi.py
+run -n upload -k -m PUT -b 65536 $ADDRESS "/bench-%d.bin"
+run -n error -k -e 404 $ADDRESS /missing.html
+
+exec 3<>/dev/tcp/127.0.0.1/8180
+printf 'GET /metrics HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n' $ADDRESS >&3
+sed '1,/^\r$/d' <&3 > "$OUTPUT.metrics"
+exec 3<&-
+echo "Résultats dans $OUTPUT, métriques du serveur dans $OUTPUT.metrics"
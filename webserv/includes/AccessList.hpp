@@ -0,0 +1,61 @@
+#ifndef ACCESSLIST_HPP
+#define ACCESSLIST_HPP
+
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+class AccessList
+{
+
+public:
+
+    AccessList();
+    ~AccessList();
+
+    void add(const std::string& network, bool allow);
+    bool isAllowed(const unsigned char* key) const;
+    bool empty() const;
+
+    static bool parseNetwork(const std::string& network, unsigned char* key, int& prefixLength);
+    static bool makeKey(const struct sockaddr* address, unsigned char* key);
+    static bool makeKey(const std::string& address, unsigned char* key);
+
+private:
+
+    enum Rule
+    {
+        RULE_NONE,
+        RULE_ALLOW,
+        RULE_DENY
+    };
+
+    // Trie binaire sur les 128 bits de l'adresse : un niveau par bit, la règle est portée par le nœud du préfixe
+    struct Node
+    {
+        Node*   children[2];
+        Rule    rule;
+
+        Node() : rule(RULE_NONE)
+        {
+            children[0] = NULL;
+            children[1] = NULL;
+        }
+    };
+
+    Node*   root;
+    bool    hasAllowRules;
+    size_t  ruleCount;
+
+    AccessList(const AccessList& other);
+    AccessList& operator=(const AccessList& other);
+
+    static void destroy(Node* node);
+    static void mapIPv4(const void* address, unsigned char* key);
+
+};
+
+#endif
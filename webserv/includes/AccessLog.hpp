@@ -0,0 +1,67 @@
+#ifndef ACCESSLOG_HPP
+#define ACCESSLOG_HPP
+
+#include "Logger.hpp"
+#include "Structures.hpp"
+#include "Clock.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+#include <ctime>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+class AccessLog
+{
+
+public:
+
+    AccessLog();
+    ~AccessLog();
+
+    void configure(const std::vector<ServerConfig>& servers, const std::vector<ServerConfig>& locationConfigs);
+    void write(const ServerConfig& serverConfig, const AccessLogEntry& entry);
+    void writeTrace(const TraceRecord& record);
+    void writeSlow(const TraceRecord& record);
+    void flush(bool force);
+    void reopen();
+    bool hasPending() const;
+
+private:
+
+    // Un fichier par chemin distinct, partagé par les blocs server qui y écrivent
+    struct File
+    {
+        int         fd;
+        bool        chrome;
+        std::string buffer;
+    };
+
+    std::map<std::string, File> files;
+    std::time_t                 lastFlush;
+
+    AccessLog(const AccessLog& other);
+    AccessLog& operator=(const AccessLog& other);
+
+    void addFile(std::map<std::string, File>& next, const std::string& path, bool chrome);
+    static int openFile(const std::string& path, bool chrome, std::string& buffer);
+    static void writeFile(const std::string& path, File& file);
+    static void formatCombined(std::string& output, const AccessLogEntry& entry);
+    static void formatJson(std::string& output, const AccessLogEntry& entry);
+    static void formatTrace(std::string& output, const TraceRecord& record);
+    static void formatTraceJson(std::string& output, const TraceRecord& record);
+    static void formatChromeTrace(std::string& output, const TraceRecord& record);
+    static void formatSlow(std::string& output, const TraceRecord& record);
+    static void appendQuoted(std::string& output, const std::string& value);
+    static void appendJsonString(std::string& output, const std::string& value);
+    static void appendSeconds(std::string& output, double seconds);
+
+};
+
+#endif
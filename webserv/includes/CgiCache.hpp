@@ -0,0 +1,56 @@
+#ifndef CGICACHE_HPP
+#define CGICACHE_HPP
+
+#include "Structures.hpp"
+#include "Logger.hpp"
+
+#include <string>
+#include <map>
+#include <list>
+#include <vector>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <ctime>
+
+class CgiCache
+{
+
+public:
+
+    CgiCache(size_t maxSize, int maxTtl);
+    ~CgiCache();
+
+    std::string buildKey(const HttpRequest& request, const std::vector<std::string>& keyHeaders) const;
+    bool lookup(const std::string& key, HttpResponse& response);
+    void store(const std::string& key, const HttpResponse& response);
+
+    static int computeTtl(const HttpResponse& response, std::time_t now);
+
+private:
+
+    struct Entry
+    {
+        HttpResponse                    response;
+        std::time_t                     expiresAt;
+        size_t                          size;
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    std::map<std::string, Entry>    entries;
+    std::list<std::string>          lru;
+    size_t                          currentSize;
+    size_t                          maxSize;
+    int                             maxTtl;
+
+    CgiCache(const CgiCache& other);
+    CgiCache& operator=(const CgiCache& other);
+
+    void remove(std::map<std::string, Entry>::iterator it);
+    static size_t entrySize(const std::string& key, const HttpResponse& response);
+    static std::string findHeader(const HttpResponse& response, const std::string& name);
+
+};
+
+#endif
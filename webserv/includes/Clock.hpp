@@ -0,0 +1,46 @@
+#ifndef CLOCK_HPP
+#define CLOCK_HPP
+
+#include <string>
+#include <ctime>
+#include <sys/time.h>
+
+// Horloge mise à jour une fois par tour de boucle ; les dates formatées ne sont recalculées qu'au changement de seconde.
+// Réservée au thread principal : le thread d'écriture du journal garde son propre cache
+class Clock
+{
+
+public:
+
+    static Clock& getInstance();
+
+    void update();
+    std::time_t now() const;
+    const struct timeval& precise() const;
+    const std::string& httpDate() const;
+    const std::string& logTime() const;
+    const std::string& commonLogTime() const;
+    const std::string& isoTime() const;
+
+    static long monotonic();
+
+private:
+
+    struct timeval  current;
+    std::time_t     formattedSecond;
+    std::string     httpDateText;
+    std::string     logTimeText;
+    std::string     commonLogTimeText;
+    std::string     isoTimeText;
+
+    Clock();
+    ~Clock();
+
+    Clock(const Clock&);
+    Clock& operator=(const Clock&);
+
+    void format();
+
+};
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "Logger.hpp"
 #include "Structures.hpp"
+#include "AccessList.hpp"
 
 #include <string>
 #include <vector>
@@ -15,6 +16,8 @@
 #include <cstdlib>
 #include <cctype>
 #include <climits>
+#include <cstring>
+#include <glob.h>
 #include <sys/stat.h>
 
 class ConfigParser
@@ -22,6 +25,7 @@ class ConfigParser
 
 public:
 
+    explicit ConfigParser(const std::string& filename);
     explicit ConfigParser(const std::string& filename, const std::string& logFile, Logger::Level logLevel);
     ~ConfigParser();
 
@@ -29,25 +33,59 @@ public:
 
     void        parse();
     const std::vector<ServerConfig>& getServers() const;
+    const std::vector<ServerConfig>& getLocationConfigs() const;
 
 private:
+
+    // Une ligne significative du fichier : directive "clé: valeur", ouverture "en-tête {" ou fermeture "}"
+    struct Token
+    {
+        enum Type
+        {
+            DIRECTIVE,
+            BLOCK_START,
+            BLOCK_END
+        };
+
+        Type            type;
+        std::string     key;
+        std::string     value;
+        size_t          fileIndex;
+        int             line;
+        int             column;
+    };
+
     std::string                 filename;
-    std::vector<ServerConfig>   servers;    
-    int                         serverCount;
-    std::istringstream          iss;
+    std::vector<ServerConfig>   servers;
+    std::vector<ServerConfig>   locationConfigs;
+    std::vector<std::string>    sourceFiles;
+    std::vector<Token>          tokens;
+    size_t                      cursor;
 
     ConfigParser(const ConfigParser& other);
 
-    void resetISS(std::istringstream& iss, const std::string& newStr);
-    void trim(std::string& str) const;
-    std::string removeQuotes(const std::string& input) const;
-    std::string cleanValue(const std::string& value);
-    int convertSizeToBytes(const std::string& sizeStr) const;
+    // Découpage en jetons
+    void tokenizeFile(const std::string& path, int depth, const Token* includedFrom);
+    void tokenizeLine(const char* begin, const char* end, size_t fileIndex, int line, int depth);
+    void expandInclude(const Token& token, int depth);
 
-    void parseServerBlock(std::ifstream& configFile, ServerConfig& serverConfig);
-    void parseKeyValue(const std::string& line, ServerConfig& serverConfig);
+    // Analyse des blocs
+    void parseServerBlock(const Token& opening);
+    void parseLocationBlock(const Token& opening, ServerConfig& serverConfig, std::vector<std::vector<Token> >& locationTokens);
+    void parseLocationHeader(const Token& token, LocationConfig& location) const;
+    ServerConfig buildLocationConfig(const ServerConfig& serverConfig, const std::vector<Token>& directives) const;
+    void validateServer(const Token& opening, const ServerConfig& serverConfig) const;
+
+    // Directives
+    void applyDirective(const Token& token, ServerConfig& serverConfig) const;
+    static void splitWords(const std::string& value, const char* separators, std::vector<std::string>& words);
+    int parseInteger(const Token& token) const;
+    int parseSize(const Token& token) const;
+    bool parseSwitch(const Token& token) const;
+
+    std::string locate(const Token& token) const;
+    void error(const Token& token, const std::string& message) const;
 
 };
 
 #endif
-
@@ -0,0 +1,39 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <string>
+#include <cstdio>
+#include <cstring>
+
+// Histogramme de latences à la manière de HdrHistogram : 4 sous-intervalles par puissance de deux (erreur relative
+// inférieure à 25 %), de la microseconde à environ 71 minutes, sans allocation à l'enregistrement
+class Histogram
+{
+
+public:
+
+    Histogram();
+    ~Histogram();
+
+    void record(unsigned long micros);
+    unsigned long getCount() const;
+    unsigned long valueAtPercentile(double percentile) const;
+    void render(std::string& output, const char* name, const char* help) const;
+
+private:
+
+    static const int    SUB_BUCKET_BITS = 2;
+    static const int    SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int    BUCKET_COUNT = SUB_BUCKETS + (32 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+    static const int    RENDERED_BUCKETS = SUB_BUCKETS + (27 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    unsigned long       counts[BUCKET_COUNT];
+    unsigned long       count;
+    unsigned long       sumMicros;
+
+    static int indexOf(unsigned long micros);
+    static unsigned long upperBound(int index);
+
+};
+
+#endif
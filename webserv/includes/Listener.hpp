@@ -0,0 +1,57 @@
+#ifndef LISTENER_HPP
+#define LISTENER_HPP
+
+#include "Logger.hpp"
+#include "Structures.hpp"
+
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <cstddef>
+#include <cerrno>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+class Listener
+{
+
+public:
+
+    Listener();
+
+    bool resolve(const std::string& host, int port);
+    bool adopt(int inheritedFd);
+    bool open(const ServerConfig& serverConfig);
+    bool configure(const ServerConfig& serverConfig);
+    void close();
+    void detach();
+
+    int getFd() const;
+    int getFamily() const;
+    const std::string& getKey() const;
+    bool getNoDelay() const;
+    int getAcceptBatch() const;
+
+    static std::string formatHost(const struct sockaddr* address, socklen_t length);
+    static std::string formatAddress(const struct sockaddr* address, socklen_t length);
+
+private:
+
+    struct sockaddr_storage address;
+    socklen_t               addressLength;
+    std::string             key;
+    std::string             unixPath;
+    int                     fd;
+    bool                    noDelay;
+    int                     acceptBatch;
+
+    void applyTcpOptions(const ServerConfig& serverConfig);
+
+};
+
+#endif
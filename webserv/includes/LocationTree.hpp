@@ -0,0 +1,45 @@
+#ifndef LOCATIONTREE_HPP
+#define LOCATIONTREE_HPP
+
+#include "Structures.hpp"
+
+#include <string>
+#include <map>
+
+class LocationTree
+{
+
+public:
+
+    LocationTree();
+    ~LocationTree();
+
+    bool insert(const std::string& key, const ServerConfig* config, bool exact);
+    const ServerConfig* findExact(const std::string& path) const;
+    const ServerConfig* findLongestPrefix(const std::string& path) const;
+
+private:
+
+    struct Node
+    {
+        std::string             label;
+        std::map<char, Node*>   children;
+        const ServerConfig*     prefixConfig;
+        const ServerConfig*     exactConfig;
+
+        explicit Node(const std::string& label) : label(label), prefixConfig(NULL), exactConfig(NULL)
+        {
+        }
+    };
+
+    Node*   root;
+
+    LocationTree(const LocationTree& other);
+    LocationTree& operator=(const LocationTree& other);
+
+    const Node* walk(const std::string& path, const ServerConfig** longestPrefix) const;
+    static void destroy(Node* node);
+
+};
+
+#endif
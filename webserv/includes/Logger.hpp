@@ -6,9 +6,16 @@
 #include <sstream>
 #include <iostream>
 #include <ctime>
+#include <cerrno>
+#include <cstdio>
 #include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
 
 #include "Macros.hpp"
+#include "Clock.hpp"
 
 class Logger
 {
@@ -24,24 +31,71 @@ public:
 
     static Logger& getInstance();
     void configure(const std::string& filename, Level fileLogLevel, Level consoleLogLevel = WARNING);
+    void setBlockOnOverflow(bool block);
+    void setConsoleFd(int fd);
     void log(const std::string& message, Level level, const char* file, int line, const char* function);
+
+    bool isEnabled(Level level) const
+    {
+        return level >= fileLogLevel || level >= consoleLogLevel;
+    }
     void cleanup();
 
 private:
 
-    std::ofstream       fileStream;
-    Level               fileLogLevel;
-    Level               consoleLogLevel;
+    // Case de l'anneau : sequence indique si elle attend un producteur ou le thread d'écriture
+    struct Slot
+    {
+        volatile size_t sequence;
+        Level           level;
+        std::time_t     time;
+        const char*     file;
+        int             line;
+        const char*     function;
+        std::string     message;
+    };
+
+    int                 fileFd;
+    int                 consoleFd;
+    volatile int        fileLogLevel;
+    volatile int        consoleLogLevel;
     pthread_mutex_t     mutex;
 
+    // File multi-producteurs sans verrou, vidée par un unique thread d'écriture
+    Slot*               ring;
+    volatile size_t     enqueuePos;
+    volatile size_t     dequeuePos;
+    volatile size_t     dropped;
+    volatile bool       blockOnOverflow;
+    volatile bool       writerRunning;
+    volatile bool       stopRequested;
+    volatile int        writerSleeping;
+    pthread_t           writer;
+    pthread_cond_t      wakeup;
+    pthread_mutex_t     wakeupMutex;
+    bool                cleanedUp;
+    std::time_t         cachedSecond;
+    std::string         cachedTime;
+
     Logger(const std::string& filename, Level fileLogLevel, Level consoleLogLevel = WARNING);
     ~Logger();
 
     Logger(const Logger&);
     Logger& operator=(const Logger&);
 
+    void enqueue(const std::string& message, Level level, const char* file, int line, const char* function);
+    void wakeWriter();
+    void writerLoop();
+    size_t drain(std::string& fileBatch, std::string& consoleBatch);
+    void writeBatches(std::string& fileBatch, std::string& consoleBatch);
+    void format(std::string& output, Level level, std::time_t time, const char* file, int line, const char* function, const std::string& message);
+
+    static void* writerMain(void* logger);
+    static void afterFork();
+    static void writeAll(int fd, const std::string& data);
+
     std::string levelToString(Level level);
-    std::string currentTime();
+    std::string currentTime(std::time_t now);
 
     static const char* RESET;
     static const char* RED;
@@ -51,4 +105,3 @@ private:
 };
 
 #endif
-
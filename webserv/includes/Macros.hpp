@@ -3,14 +3,93 @@
 
 /*  Logger  */ 
 
+// Niveau minimal compilé : 0 (INFO), 1 (WARNING) ou 2 (ERROR) ; "make release" le fixe à 1
+#ifndef LOG_MIN_LEVEL
+# define LOG_MIN_LEVEL 0
+#endif
+
+// Le niveau actif est testé avant d'évaluer le message : rien n'est construit pour un message filtré
+#define LOG_AT(level, message) \
+    do { \
+        if (Logger::getInstance().isEnabled(level)) \
+            Logger::getInstance().log((message), (level), __FILE__, __LINE__, __FUNCTION__); \
+    } while (0)
+
+// Variante en flux pour les messages qui mêlent texte et nombres : l'ostringstream n'est construit que si le niveau est actif
+#define LOG_STREAM_AT(level, expression) \
+    do { \
+        if (Logger::getInstance().isEnabled(level)) \
+        { \
+            std::ostringstream logStream; \
+            logStream << expression; \
+            Logger::getInstance().log(logStream.str(), (level), __FILE__, __LINE__, __FUNCTION__); \
+        } \
+    } while (0)
+
+// Sous le niveau minimal, l'appel disparaît : sizeof garde le message vérifié par le compilateur sans l'évaluer
+#define LOG_DISCARD(message) \
+    ((void)sizeof((message)))
+
+// Même principe en flux : la branche morte est vérifiée puis supprimée par le compilateur
+#define LOG_STREAM_DISCARD(expression) \
+    do { \
+        if (false) \
+        { \
+            std::ostringstream logStream; \
+            logStream << expression; \
+        } \
+    } while (0)
+
 // Definition
-#define LOG_INFO(message) \
-    Logger::getInstance().log((message), Logger::INFO, __FILE__, __LINE__, __FUNCTION__)
+#if LOG_MIN_LEVEL <= 0
+# define LOG_INFO(message) LOG_AT(Logger::INFO, message)
+# define LOG_INFO_STREAM(expression) LOG_STREAM_AT(Logger::INFO, expression)
+#else
+# define LOG_INFO(message) LOG_DISCARD(message)
+# define LOG_INFO_STREAM(expression) LOG_STREAM_DISCARD(expression)
+#endif
+
+#if LOG_MIN_LEVEL <= 1
+# define LOG_WARNING(message) LOG_AT(Logger::WARNING, message)
+#else
+# define LOG_WARNING(message) LOG_DISCARD(message)
+#endif
+
+#define LOG_ERROR(message) LOG_AT(Logger::ERROR, message)
+
+// Nombre de cases de l'anneau du journal (puissance de deux)
+#define LOG_RING_SIZE 8192
+
+// Délai maximal (millisecondes) avant que le thread d'écriture ne vide l'anneau
+#define LOG_FLUSH_INTERVAL_MS 100
+
+/*  Server  */
+
+// Taille du tampon de lecture par appel à read()
+#define READ_BUFFER_SIZE 8192
+
+// Taille maximale de la ligne de requête et des en-têtes
+#define MAX_HEADER_SIZE 16384
+
+// Volume maximal ignoré après un rejet anticipé avant de fermer la connexion
+#define DISCARD_LIMIT (1024 * 1024)
+
+// Quantité maximale déplacée par appel à splice() lors d'un envoi brut
+#define SPLICE_CHUNK_SIZE 65536
+
+// Délai de vidage à l'arrêt (secondes) quand aucun bloc server ne fixe shutdown_timeout
+#define DEFAULT_SHUTDOWN_TIMEOUT 30
+
+// Limitation par adresse : taille maximale de la table et intervalle de purge des entrées inactives (secondes)
+#define RATE_LIMIT_MAX_ENTRIES 65536
+#define RATE_LIMIT_DECAY_INTERVAL 10
 
-#define LOG_WARNING(message) \
-    Logger::getInstance().log((message), Logger::WARNING, __FILE__, __LINE__, __FUNCTION__)
+// Journal d'accès : taille du tampon avant écriture et délai maximal (secondes) avant vidage
+#define ACCESS_LOG_BUFFER_SIZE 65536
+#define ACCESS_LOG_FLUSH_INTERVAL 1
 
-#define LOG_ERROR(message) \
-    Logger::getInstance().log((message), Logger::ERROR, __FILE__, __LINE__, __FUNCTION__) 
+// Variables d'environnement de la mise à jour du binaire à chaud
+#define LISTEN_FDS_ENV "WEBSERV_LISTEN_FDS"
+#define UPGRADE_READY_ENV "WEBSERV_UPGRADE_READY_FD"
 
-#endif
\ No newline at end of file
+#endif
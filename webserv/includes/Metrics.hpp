@@ -0,0 +1,91 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include "Histogram.hpp"
+
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <sys/time.h>
+
+// Compteurs du processus, modifiés uniquement par le thread principal : un incrément coûte une addition
+class Metrics
+{
+
+public:
+
+    enum Counter
+    {
+        CONNECTIONS_ACCEPTED,
+        CONNECTIONS_CLOSED,
+        CONNECTIONS_REJECTED,
+        REQUESTS_RATE_LIMITED,
+        REQUESTS_DENIED,
+        RESPONSE_BYTES,
+        CGI_EXECUTIONS,
+        CGI_CACHE_HITS,
+        CGI_CACHE_MISSES,
+        LOOP_ITERATIONS,
+        SLOW_REQUESTS,
+        COUNTER_COUNT
+    };
+
+    enum Gauge
+    {
+        ACTIVE_CONNECTIONS,
+        LISTENERS,
+        RATE_LIMITER_ENTRIES,
+        GAUGE_COUNT
+    };
+
+    enum Timing
+    {
+        REQUEST_DURATION,
+        HANDLER_DURATION,
+        CGI_DURATION,
+        STATIC_FILE_DURATION,
+        LOOP_DURATION,
+        TIMING_COUNT
+    };
+
+    static Metrics& getInstance();
+
+    void increment(Counter counter, unsigned long amount = 1)
+    {
+        counters[counter] += amount;
+    }
+
+    void setGauge(Gauge gauge, unsigned long value)
+    {
+        gauges[gauge] = value;
+    }
+
+    void observe(Timing timing, unsigned long micros)
+    {
+        histograms[timing].record(micros);
+    }
+
+    void countResponse(int statusCode);
+    const Histogram& getHistogram(Timing timing) const;
+    unsigned long getCounter(Counter counter) const;
+    unsigned long getResponseCount() const;
+    std::string render() const;
+
+    static unsigned long elapsedMicros(const struct timeval& start);
+
+private:
+
+    unsigned long   counters[COUNTER_COUNT];
+    unsigned long   gauges[GAUGE_COUNT];
+    unsigned long   responses[6];
+    Histogram       histograms[TIMING_COUNT];
+
+    Metrics();
+    ~Metrics();
+
+    Metrics(const Metrics&);
+    Metrics& operator=(const Metrics&);
+
+};
+
+#endif
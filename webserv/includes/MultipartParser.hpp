@@ -0,0 +1,66 @@
+#ifndef MULTIPARTPARSER_HPP
+#define MULTIPARTPARSER_HPP
+
+#include "Logger.hpp"
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cctype>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/stat.h>
+
+class MultipartParser
+{
+
+public:
+
+    MultipartParser(const std::string& boundary, const std::string& uploadDir);
+    ~MultipartParser();
+
+    bool feed(const char* data, size_t length);
+    bool isComplete() const;
+    bool hasFailed() const;
+    const std::vector<std::string>& getFiles() const;
+
+private:
+
+    enum State
+    {
+        PREAMBLE,
+        AFTER_DELIMITER,
+        PART_HEADERS,
+        PART_BODY,
+        DONE,
+        FAILED
+    };
+
+    State                       state;
+    std::string                 delimiter;
+    size_t                      skipTable[256];
+    std::string                 uploadDir;
+    std::string                 pending;
+    int                         tempFd;
+    std::string                 tempPath;
+    std::string                 fileName;
+    std::vector<std::string>    files;
+
+    MultipartParser(const MultipartParser& other);
+    MultipartParser& operator=(const MultipartParser& other);
+
+    bool process();
+    size_t findDelimiter() const;
+    bool parsePartHeaders(const std::string& headers);
+    bool openTempFile();
+    bool writePartData(const char* data, size_t length);
+    bool finishPart();
+    void abortPart();
+    void fail(const std::string& reason);
+    static std::string sanitizeFileName(const std::string& name);
+
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef RATELIMITER_HPP
+#define RATELIMITER_HPP
+
+#include "Logger.hpp"
+#include "Structures.hpp"
+#include "AccessList.hpp"
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <sys/time.h>
+
+class RateLimiter
+{
+
+public:
+
+    RateLimiter();
+    ~RateLimiter();
+
+    bool acquireConnection(const std::string& address, int maxConnections);
+    void releaseConnection(const std::string& address);
+    bool consumeRequest(const std::string& address, int rate, int burst);
+    void decay();
+    size_t size() const;
+
+private:
+
+    // Adresse sur 16 octets (IPv4 projetée en ::ffff:a.b.c.d), seau de jetons et connexions ouvertes
+    struct Entry
+    {
+        unsigned char   address[16];
+        bool            used;
+        int             connections;
+        double          tokens;
+        long            lastRefill;
+    };
+
+    std::vector<Entry>  entries;
+    size_t              count;
+    long                lastDecay;
+
+    RateLimiter(const RateLimiter& other);
+    RateLimiter& operator=(const RateLimiter& other);
+
+    Entry* find(const unsigned char* address, bool create);
+    void rehash(size_t capacity);
+    static size_t hash(const unsigned char* key);
+    static long currentTimeMs();
+
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef RAWUPLOAD_HPP
+#define RAWUPLOAD_HPP
+
+#include "Structures.hpp"
+#include "Logger.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+class RawUpload
+{
+
+public:
+
+    RawUpload(const std::string& uploadDir, const std::string& fileName, bool useSplice, FsyncPolicy fsyncPolicy);
+    ~RawUpload();
+
+    bool open();
+    bool write(const char* data, size_t length);
+    ssize_t spliceFrom(int socketFd, size_t maxBytes);
+    bool canSplice() const;
+    void disableSplice();
+    bool hasFailed() const;
+    bool finish();
+    const std::string& getFileName() const;
+
+private:
+
+    std::string     uploadDir;
+    std::string     fileName;
+    std::string     tempPath;
+    int             fileFd;
+    int             pipeFds[2];
+    bool            useSplice;
+    bool            failed;
+    FsyncPolicy     fsyncPolicy;
+
+    RawUpload(const RawUpload& other);
+    RawUpload& operator=(const RawUpload& other);
+
+    void closePipe();
+    void abort();
+
+};
+
+#endif
@@ -12,30 +12,56 @@
 #include <sys/stat.h>
 #include <dirent.h>
 #include <cerrno>
+#include <algorithm>
 
 #include "Structures.hpp"
 #include "Logger.hpp"
 #include "CgiHandler.hpp"
+#include "CgiCache.hpp"
+#include "MultipartParser.hpp"
+#include "RawUpload.hpp"
+#include "Metrics.hpp"
+#include "Clock.hpp"
 
 class RequestHandler
 {
 
 public:
     RequestHandler();
+    ~RequestHandler();
 
-    void setServerConfigs(const std::vector<ServerConfig>& configs);
+    void setServerConfigs(const std::vector<ServerConfig>& servers, const std::vector<ServerConfig>& locationConfigs);
 
-    HttpResponse handleRequest(const HttpRequest& request);
+    HttpResponse handleRequest(const HttpRequest& request, const ServerConfig& serverConfig);
     HttpRequest parseRequest(const std::string& requestText);
 
     std::string urlDecode(const std::string& str);
     std::string loadErrorPage(int statusCode);
+    HttpResponse generateErrorResponse(int statusCode, const std::string& statusMessage);
+
+    // Réception du corps en flux
+    MultipartParser* createUploadParser(const HttpRequest& request, const ServerConfig& serverConfig);
+    RawUpload* createRawUpload(const HttpRequest& request, const ServerConfig& serverConfig);
+    size_t getMaxBodySize(const ServerConfig& serverConfig);
+    bool validateHeaders(const HttpRequest& request, const ServerConfig& serverConfig, HttpResponse& errorResponse);
+    bool isCgiRequest(const HttpRequest& request, const ServerConfig& serverConfig);
+
+    // Chemins et types de contenu (publics pour bench/microbench)
+    std::string determineMimeType(const std::string& filePath);
+    std::string normalizePath(const std::string& path);
+
+    // Trace de la requête en cours de traitement, complétée par le CGI
+    void setTrace(RequestTrace* trace);
+    void markTrace(RequestTrace::Phase phase);
 
 private:
 
-    std::vector<ServerConfig>   serverConfigs;
-    int                         current_port;
-    const ServerConfig* currentServerConfig;
+    const ServerConfig*                         currentServerConfig;
+    RequestTrace*                               currentTrace;
+    std::map<const ServerConfig*, CgiCache*>    cgiCaches;
+
+    RequestHandler(const RequestHandler& other);
+    RequestHandler& operator=(const RequestHandler& other);
 
     // Parsing de la requête
     void parseRequestLine(const std::string& line, HttpRequest& request);
@@ -45,9 +71,6 @@ private:
     // Validation de la requête
     bool isValidRequest(const HttpRequest& request);
 
-    // Gestion des extensions
-    std::string determineMimeType(const std::string& filePath);
-
     // Gestion des pages d'erreurs
     HttpResponse generateNotFoundResponse();
     HttpResponse generateInternalServerErrorResponse();
@@ -56,20 +79,17 @@ private:
     HttpResponse handleGetRequest(const HttpRequest& request);
     HttpResponse handlePostRequest(const HttpRequest& request);
     HttpResponse handleDeleteRequest(const HttpRequest& request);
+    HttpResponse handlePutRequest(const HttpRequest& request);
 
     // Gestion des CGI
     HttpResponse handleCgiRequest(const HttpRequest& request);
-    bool isCgiRequest(const HttpRequest& request);
     std::string getScriptPathFromUri(const std::string& uri);
+    void addCgiCaches(const std::vector<ServerConfig>& configs);
+    void clearCgiCaches();
 
     // Gestion des redirections
     HttpResponse handleGetRequestWithRedirection(const HttpRequest& request);
 
-    // Gestion de la configuration
-    void setServerPort(int port);
-    int extractPortFromHostHeader(const std::string& hostHeader);
-    ServerConfig getServerConfigForPort(int port);
-
     // Gestion des données de formulaire
     std::map<std::string, std::string> parseFormData(const std::string& body);
     bool performAction(const std::map<std::string, std::string>& formData);
@@ -77,15 +97,12 @@ private:
     // Gestion du contenu
     bool isMultipartFormData(const HttpRequest& request);
     std::string getBoundary(const std::string& contentType);
-    void parseMultipartFormData(const std::string& body, const std::string& boundary, std::vector<FilePart>& files);
     std::string generateDirectoryListingHtml(const std::string& directoryPath);
 
     // Gestion des fichiers
-    void saveFile(const std::string& content, const std::string& fileName);
-    FilePart extractFilePart(const std::string& part);
+    std::string getUploadDirectory();
     bool isDirectory(const std::string& path);
-    std::string getAbsolutePath(const std::string& uri, int port);
-    std::string normalizePath(const std::string& path);
+    std::string getAbsolutePath(const std::string& uri);
 
     // Assistance
     std::string getUriBasePath();
@@ -7,6 +7,7 @@
 
 #include "RequestHandler.hpp"
 #include "Logger.hpp"
+#include "Clock.hpp"
 
 class Response
 {
@@ -0,0 +1,49 @@
+#ifndef ROUTINGTABLE_HPP
+#define ROUTINGTABLE_HPP
+
+#include "Structures.hpp"
+#include "Logger.hpp"
+#include "LocationTree.hpp"
+#include "AccessList.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cctype>
+
+class RoutingTable
+{
+
+public:
+
+    RoutingTable(const std::vector<ServerConfig>& servers, const std::vector<ServerConfig>& locationConfigs);
+    ~RoutingTable();
+
+    void addListener(int listenFd, size_t serverIndex);
+    const ServerConfig* resolve(int listenFd, const std::string& hostHeader) const;
+    const ServerConfig* resolveLocation(const ServerConfig* serverConfig, const std::string& uri) const;
+    bool isAllowed(int listenFd, const struct sockaddr* address) const;
+    bool isAllowed(const ServerConfig* serverConfig, const std::string& address) const;
+    const std::vector<ServerConfig>& getServers() const;
+    const std::vector<ServerConfig>& getLocationConfigs() const;
+
+private:
+
+    const std::vector<ServerConfig>             servers;
+    const std::vector<ServerConfig>             locationConfigs;
+    std::vector<LocationTree*>                  pathTrees;
+    std::vector<LocationTree*>                  extensionTrees;
+    std::vector<AccessList*>                    accessLists;
+    std::map<std::string, const ServerConfig*>  routes;
+    std::map<int, const ServerConfig*>          defaultServers;
+    std::map<int, std::vector<const ServerConfig*> > listenerServers;
+
+    RoutingTable(const RoutingTable& other);
+    RoutingTable& operator=(const RoutingTable& other);
+
+    const AccessList* findAccessList(const ServerConfig* serverConfig) const;
+    static std::string makeKey(int listenFd, const std::string& host);
+
+};
+
+#endif
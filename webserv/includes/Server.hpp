@@ -4,11 +4,19 @@
 #include <iostream>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
 #include <cstdlib>
 #include <vector>
+#include <map>
+#include <fcntl.h>
+#include <climits>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <ctime>
+#include <csignal>
 
 #include "ConfigParser.hpp"
 #include "RequestHandler.hpp"
@@ -17,6 +25,11 @@
 #include "Structures.hpp"
 #include "SessionManager.hpp"
 #include "Cookies.hpp"
+#include "RoutingTable.hpp"
+#include "Listener.hpp"
+#include "RateLimiter.hpp"
+#include "AccessLog.hpp"
+#include "Metrics.hpp"
 
 class Server
 {
@@ -27,27 +40,98 @@ public:
     ~Server();
 
     void start();
+    void setExecutable(const std::string& path);
+
+    static bool openSignalPipe();
+    static void notifySignal(int signum);
 
 private:
 
     static bool         isRunning;
-    std::vector<int>    server_fds;
+    static int          signalPipe[2];
+    std::map<int, Listener> listeners;
+    std::map<int, Connection> connections;
+    fd_set              master_set;
+    fd_set              write_set;
+    int                 max_fd;
     int                 new_socket;
     int                 addrlen;
     struct sockaddr_in  address;
     std::string         basePath;
 
+    std::string         configFilePath;
+    std::string         logFilePath;
+    Logger::Level       logLevel;
     ConfigParser        config;
+    RoutingTable*       routingTable;
+    std::vector<RoutingTable*> retiredTables;
+    std::string         executablePath;
+    bool                draining;
+    bool                shuttingDown;
+    std::time_t         drainDeadline;
+    int                 upgradePipe;
+    pid_t               upgradePid;
     RequestHandler      requestHandler;
     Response            response;
     SessionManager      sessionManager;
+    RateLimiter         rateLimiter;
+    AccessLog           accessLog;
 
     Server(const Server &other);
     Server &operator=(const Server &other);
 
     void shutdownServer(const std::string& reason);
     void setupServerSockets();
-    void safeWrite(int fd, const std::string& data);
+    bool bindListeners(RoutingTable& table, std::map<int, Listener>& result);
+    void commitListeners(std::map<int, Listener>& next);
+    void closeNewListeners(std::map<int, Listener>& opened);
+    int findListener(const std::string& key) const;
+    void watchFd(int fd);
+
+    // Signaux et rechargement
+    void handleSignals();
+    void reloadConfiguration();
+    void releaseRetiredTables();
+    void configureLogger();
+
+    // Mise à jour du binaire à chaud
+    void adoptInheritedListeners();
+    void notifyUpgradeReady();
+    void startUpgrade();
+    void finishUpgrade();
+    void beginDrain(bool handOff);
+
+    // Arrêt progressif
+    void beginShutdown();
+    int getShutdownTimeout() const;
+    void closeAllConnections();
+    void reapChildren();
+
+    // Gestion des connexions clientes
+    void acceptConnection(int listen_fd);
+    void readFromClient(int fd);
+    bool processConnection(Connection& conn);
+    int beginRequest(Connection& conn);
+    int readFixedBody(Connection& conn);
+    int readChunkedBody(Connection& conn);
+    bool consumeBody(Connection& conn, const char* data, size_t length);
+    bool completeRequest(Connection& conn);
+    bool queueOutput(Connection& conn, const std::string& data);
+    bool flushOutput(Connection& conn);
+    bool sendResponse(Connection& conn, HttpResponse& httpResponse, bool keepAlive);
+    void logAccess(Connection& conn, const HttpResponse& httpResponse, size_t bytesSent);
+    void queueTrace(Connection& conn, const ServerConfig& serverConfig, const HttpResponse& httpResponse, size_t bytesSent);
+    void advanceTraces(Connection& conn, size_t bytesWritten);
+    HttpResponse buildInternalResponse(const Connection& conn);
+    std::string renderMetrics();
+    std::string renderStatus(const Connection& current) const;
+    static const char* describeState(const Connection& conn);
+    int handleExpectation(Connection& conn);
+    bool rejectRequest(Connection& conn, int statusCode, const std::string& statusMessage);
+    bool rejectRequest(Connection& conn, HttpResponse& httpResponse);
+    void discardInput(Connection& conn);
+    void resetConnection(Connection& conn);
+    void closeConnection(int fd);
 
 };
 
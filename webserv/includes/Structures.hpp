@@ -5,9 +5,45 @@
 #include <string>
 #include <map>
 #include <ctime>
+#include <sys/time.h>
 
 std::string urlDecode(const std::string& str);
 
+class MultipartParser;
+class RawUpload;
+class RoutingTable;
+
+enum FsyncPolicy
+{
+    FSYNC_OFF,
+    FSYNC_ALWAYS,
+    FSYNC_DATA
+};
+
+enum TraceMode
+{
+    TRACE_OFF,
+    TRACE_LOG,
+    TRACE_CHROME
+};
+
+enum LocationMatch
+{
+    LOCATION_PREFIX,
+    LOCATION_EXACT,
+    LOCATION_EXTENSION
+};
+
+// Bloc location d'un serveur ; sa configuration effective est rangée à part par le ConfigParser
+struct LocationConfig
+{
+
+    std::string                         path;
+    LocationMatch                       match;
+    size_t                              configIndex;
+
+};
+
 struct HttpRequest
 {
 
@@ -18,6 +54,7 @@ struct HttpRequest
     std::string                         queryString;
     std::map<std::string, std::string>  headers;
     std::map<std::string, std::string>  formData;
+    std::vector<std::string>            uploadedFiles;
 
     std::string getHeader(const std::string& key) const
     {
@@ -52,14 +89,6 @@ struct HttpResponse
 
 };
 
-struct FilePart
-{
-
-    std::string                         fileName;
-    std::string                         fileContent;
-
-};
-
 struct ServerConfig
 {
 
@@ -81,6 +110,185 @@ struct ServerConfig
     std::map<std::string, std::string>  cgi_handlers;
     std::map<std::string, std::string>  redirections;
     std::map<std::string, std::string>  route_specific_root;
+    bool                                cgi_cache;
+    int                                 cgi_cache_max_size;
+    int                                 cgi_cache_ttl;
+    std::vector<std::string>            cgi_cache_key_headers;
+    bool                                upload_splice;
+    FsyncPolicy                         upload_fsync;
+    std::vector<LocationConfig>         locations;
+    int                                 listen_backlog;
+    int                                 tcp_defer_accept;
+    int                                 tcp_fastopen;
+    bool                                tcp_nodelay;
+    int                                 accept_batch;
+    int                                 shutdown_timeout;
+    int                                 rate_limit;
+    int                                 rate_limit_burst;
+    int                                 max_connections_per_ip;
+    bool                                log_overflow_block;
+    std::string                         access_log;
+    bool                                access_log_json;
+    bool                                metrics;
+    bool                                status;
+    TraceMode                           trace;
+    std::string                         trace_file;
+    std::string                         slow_log;
+    int                                 slow_log_threshold;
+
+    ServerConfig() : generate_index_html(false), directory_listing(false), port(0), client_max_body_size(0),
+        cgi_cache(false), cgi_cache_max_size(1024 * 1024), cgi_cache_ttl(60), upload_splice(false), upload_fsync(FSYNC_OFF),
+        listen_backlog(100), tcp_defer_accept(0), tcp_fastopen(0), tcp_nodelay(false), accept_batch(64),
+        shutdown_timeout(-1), rate_limit(0), rate_limit_burst(0), max_connections_per_ip(0),
+        log_overflow_block(false), access_log_json(false), metrics(false), status(false), trace(TRACE_OFF), trace_file("trace.json"),
+        slow_log_threshold(1000)
+    {
+    }
+
+};
+
+// Une ligne du journal d'accès ; upstreamTime vaut -1 quand aucun CGI n'a été exécuté
+struct AccessLogEntry
+{
+
+    std::string                         remoteAddress;
+    std::string                         vhost;
+    std::string                         method;
+    std::string                         uri;
+    std::string                         httpVersion;
+    std::string                         referer;
+    std::string                         userAgent;
+    int                                 status;
+    size_t                              bytesSent;
+    double                              requestTime;
+    double                              upstreamTime;
+    int                                 requests;
+
+};
+
+// Bornes des phases d'une requête en microsecondes d'horloge monotone ; -1 pour une phase non atteinte
+struct RequestTrace
+{
+
+    enum Phase
+    {
+        RECEIVED,
+        PARSED,
+        ROUTED,
+        BODY_RECEIVED,
+        HANDLER_START,
+        CGI_SPAWN,
+        CGI_EXIT,
+        HANDLER_END,
+        FIRST_BYTE,
+        LAST_BYTE,
+        PHASE_COUNT
+    };
+
+    long                                marks[PHASE_COUNT];
+    std::string                         script;
+
+    RequestTrace()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        for (int i = 0; i < PHASE_COUNT; ++i)
+        {
+            marks[i] = -1;
+        }
+        script.clear();
+    }
+
+};
+
+// Trace d'une réponse en file d'envoi : les décalages comptent les octets restant à envoyer avant son premier et son dernier octet.
+// Tant que headersInRequest est vrai, les en-têtes sont encore ceux de conn.request et ne sont copiés que pour une requête lente
+struct TraceRecord
+{
+
+    RequestTrace                        trace;
+    TraceMode                           mode;
+    std::string                         path;
+    bool                                json;
+    int                                 fd;
+    std::string                         remoteAddress;
+    std::string                         method;
+    std::string                         uri;
+    std::string                         httpVersion;
+    int                                 status;
+    size_t                              firstByteOffset;
+    size_t                              lastByteOffset;
+    std::string                         vhost;
+    std::string                         slowLog;
+    long                                slowThreshold;
+    bool                                headersInRequest;
+    std::map<std::string, std::string>  headers;
+
+    TraceRecord() : mode(TRACE_OFF), json(false), fd(-1), status(0), firstByteOffset(0), lastByteOffset(0), slowThreshold(0),
+        headersInRequest(false)
+    {
+    }
+
+};
+
+struct Connection
+{
+
+    enum State
+    {
+        READING_HEADERS,
+        READING_BODY,
+        DISCARDING
+    };
+
+    enum ChunkState
+    {
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_DATA_END,
+        CHUNK_TRAILER
+    };
+
+    int                                 fd;
+    int                                 listenFd;
+    std::string                         remoteAddress;
+    RoutingTable*                       routingTable;
+    const ServerConfig*                 serverConfig;
+    State                               state;
+    std::string                         buffer;
+    std::string                         headerText;
+    HttpRequest                         request;
+    size_t                              contentLength;
+    size_t                              bodyReceived;
+    size_t                              maxBodySize;
+    bool                                chunked;
+    ChunkState                          chunkState;
+    size_t                              chunkRemaining;
+    size_t                              discarded;
+    MultipartParser*                    multipart;
+    RawUpload*                          rawUpload;
+    std::string                         output;
+    bool                                closeAfterWrite;
+    bool                                shutdownAfterWrite;
+    struct timeval                      requestStart;
+    double                              upstreamTime;
+    int                                 requests;
+    unsigned long                       bytesIn;
+    unsigned long                       bytesOut;
+    std::time_t                         acceptedAt;
+    RequestTrace                        trace;
+    std::vector<TraceRecord>            traces;
+
+    Connection() : fd(-1), listenFd(-1), routingTable(NULL), serverConfig(NULL), state(READING_HEADERS), contentLength(0), bodyReceived(0), maxBodySize(0), chunked(false),
+        chunkState(CHUNK_SIZE), chunkRemaining(0), discarded(0), multipart(NULL), rawUpload(NULL),
+        closeAfterWrite(false), shutdownAfterWrite(false), upstreamTime(-1), requests(0), bytesIn(0), bytesOut(0),
+        acceptedAt(std::time(0))
+    {
+        gettimeofday(&requestStart, NULL);
+    }
 
 };
 
@@ -0,0 +1,178 @@
+#include "../includes/AccessList.hpp"
+
+AccessList::AccessList() : root(new Node()), hasAllowRules(false), ruleCount(0)
+{
+}
+
+AccessList::~AccessList()
+{
+    destroy(root);
+}
+
+/**************************************************************************
+ *                          METHODES PUBLIQUES                            *
+ * ***********************************************************************/
+
+// Le réseau doit avoir été validé par parseNetwork ; à préfixe égal, le refus l'emporte
+void AccessList::add(const std::string& network, bool allow)
+{
+    unsigned char key[16];
+    int prefixLength;
+    if (!parseNetwork(network, key, prefixLength))
+    {
+        return;
+    }
+
+    Node* node = root;
+    for (int bit = 0; bit < prefixLength; ++bit)
+    {
+        int branch = (key[bit / 8] >> (7 - bit % 8)) & 1;
+        if (!node->children[branch])
+        {
+            node->children[branch] = new Node();
+        }
+        node = node->children[branch];
+    }
+
+    if (node->rule != RULE_DENY)
+    {
+        node->rule = allow ? RULE_ALLOW : RULE_DENY;
+    }
+    if (allow)
+    {
+        hasAllowRules = true;
+    }
+    ++ruleCount;
+}
+
+// La règle du plus long préfixe correspondant décide ; sans correspondance, l'accès n'est refusé
+// que si des réseaux autorisés ont été déclarés
+bool AccessList::isAllowed(const unsigned char* key) const
+{
+    Rule decision = RULE_NONE;
+    const Node* node = root;
+
+    for (int bit = 0; node; ++bit)
+    {
+        if (node->rule != RULE_NONE)
+        {
+            decision = node->rule;
+        }
+        if (bit == 128)
+        {
+            break;
+        }
+        node = node->children[(key[bit / 8] >> (7 - bit % 8)) & 1];
+    }
+
+    if (decision == RULE_NONE)
+    {
+        return !hasAllowRules;
+    }
+    return decision == RULE_ALLOW;
+}
+
+bool AccessList::empty() const
+{
+    return ruleCount == 0;
+}
+
+// Formes acceptées : "all", une adresse IPv4 ou IPv6 seule, ou suivie de "/longueur"
+bool AccessList::parseNetwork(const std::string& network, unsigned char* key, int& prefixLength)
+{
+    if (network == "all")
+    {
+        memset(key, 0, 16);
+        prefixLength = 0;
+        return true;
+    }
+
+    std::string::size_type slash = network.find('/');
+    std::string address = network.substr(0, slash);
+
+    int maxLength;
+    struct in_addr v4;
+    if (inet_pton(AF_INET, address.c_str(), &v4) == 1)
+    {
+        mapIPv4(&v4, key);
+        maxLength = 32;
+    }
+    else if (inet_pton(AF_INET6, address.c_str(), key) == 1)
+    {
+        maxLength = 128;
+    }
+    else
+    {
+        return false;
+    }
+
+    prefixLength = maxLength;
+    if (slash != std::string::npos)
+    {
+        std::string length = network.substr(slash + 1);
+        char* end = NULL;
+        long value = std::strtol(length.c_str(), &end, 10);
+        if (length.empty() || *end != '\0' || value < 0 || value > maxLength)
+        {
+            return false;
+        }
+        prefixLength = static_cast<int>(value);
+    }
+
+    // Une adresse IPv4 occupe les 32 derniers bits de ::ffff:0:0/96
+    if (maxLength == 32)
+    {
+        prefixLength += 96;
+    }
+    return true;
+}
+
+// Les sockets Unix n'ont pas d'adresse : makeKey échoue et aucune règle ne s'applique
+bool AccessList::makeKey(const struct sockaddr* address, unsigned char* key)
+{
+    if (address->sa_family == AF_INET)
+    {
+        mapIPv4(&reinterpret_cast<const struct sockaddr_in*>(address)->sin_addr, key);
+        return true;
+    }
+    if (address->sa_family == AF_INET6)
+    {
+        memcpy(key, &reinterpret_cast<const struct sockaddr_in6*>(address)->sin6_addr, 16);
+        return true;
+    }
+    return false;
+}
+
+bool AccessList::makeKey(const std::string& address, unsigned char* key)
+{
+    struct in_addr v4;
+    if (inet_pton(AF_INET, address.c_str(), &v4) == 1)
+    {
+        mapIPv4(&v4, key);
+        return true;
+    }
+    return inet_pton(AF_INET6, address.c_str(), key) == 1;
+}
+
+/**************************************************************************
+ *                          METHODES PRIVEES                              *
+ * ***********************************************************************/
+
+void AccessList::destroy(Node* node)
+{
+    if (!node)
+    {
+        return;
+    }
+    destroy(node->children[0]);
+    destroy(node->children[1]);
+    delete node;
+}
+
+void AccessList::mapIPv4(const void* address, unsigned char* key)
+{
+    memset(key, 0, 10);
+    key[10] = 0xff;
+    key[11] = 0xff;
+    memcpy(key + 12, address, 4);
+}
@@ -0,0 +1,486 @@
+#include "../includes/AccessLog.hpp"
+
+static const char* PHASE_NAMES[RequestTrace::PHASE_COUNT] = {
+    "received", "parsed", "routed", "body_received", "handler_start",
+    "cgi_spawn", "cgi_exit", "handler_end", "first_byte", "last_byte"
+};
+
+// Intervalles affichés dans chrome://tracing, d'une borne à l'autre
+static const struct
+{
+    const char*         name;
+    RequestTrace::Phase from;
+    RequestTrace::Phase to;
+} CHROME_SPANS[] = {
+    { "read_headers", RequestTrace::RECEIVED, RequestTrace::PARSED },
+    { "route", RequestTrace::PARSED, RequestTrace::ROUTED },
+    { "read_body", RequestTrace::ROUTED, RequestTrace::BODY_RECEIVED },
+    { "handler", RequestTrace::HANDLER_START, RequestTrace::HANDLER_END },
+    { "cgi_fork", RequestTrace::HANDLER_START, RequestTrace::CGI_SPAWN },
+    { "cgi_run", RequestTrace::CGI_SPAWN, RequestTrace::CGI_EXIT },
+    { "write", RequestTrace::FIRST_BYTE, RequestTrace::LAST_BYTE }
+};
+
+AccessLog::AccessLog() : lastFlush(Clock::getInstance().now())
+{
+}
+
+AccessLog::~AccessLog()
+{
+    flush(true);
+    for (std::map<std::string, File>::iterator it = files.begin(); it != files.end(); ++it)
+    {
+        if (it->second.fd >= 0)
+        {
+            close(it->second.fd);
+        }
+    }
+    files.clear();
+}
+
+/**************************************************************************
+ *                          METHODES PUBLIQUES                            *
+ * ***********************************************************************/
+
+// Ouvre les fichiers des nouveaux chemins, garde ceux déjà ouverts et ferme ceux qui ne servent plus ;
+// une location peut écrire dans son propre fichier ou couper le journal avec "access_log: off"
+void AccessLog::configure(const std::vector<ServerConfig>& servers, const std::vector<ServerConfig>& locationConfigs)
+{
+    std::map<std::string, File> next;
+
+    for (size_t i = 0; i < servers.size() + locationConfigs.size(); ++i)
+    {
+        const ServerConfig& config = (i < servers.size()) ? servers[i] : locationConfigs[i - servers.size()];
+        if (!config.access_log.empty() && config.access_log != "off")
+        {
+            addFile(next, config.access_log, false);
+        }
+        if (config.trace == TRACE_CHROME)
+        {
+            addFile(next, config.trace_file, true);
+        }
+        if (!config.slow_log.empty())
+        {
+            addFile(next, config.slow_log, false);
+        }
+    }
+
+    for (std::map<std::string, File>::iterator it = files.begin(); it != files.end(); ++it)
+    {
+        writeFile(it->first, it->second);
+        if (it->second.fd >= 0)
+        {
+            close(it->second.fd);
+        }
+    }
+    files.swap(next);
+}
+
+// Les traces "log" suivent le format du journal d'accès ; les traces "chrome" sont des événements du format Trace Event
+void AccessLog::writeTrace(const TraceRecord& record)
+{
+    std::map<std::string, File>::iterator it = files.find(record.path);
+    if (it == files.end())
+    {
+        return;
+    }
+
+    if (it->second.chrome)
+        formatChromeTrace(it->second.buffer, record);
+    else if (record.json)
+        formatTraceJson(it->second.buffer, record);
+    else
+        formatTrace(it->second.buffer, record);
+
+    if (it->second.buffer.size() >= ACCESS_LOG_BUFFER_SIZE)
+    {
+        writeFile(it->first, it->second);
+    }
+}
+
+// Écrit sans attendre le vidage périodique : une requête lente est rare et doit être lisible tout de suite
+void AccessLog::writeSlow(const TraceRecord& record)
+{
+    std::map<std::string, File>::iterator it = files.find(record.slowLog);
+    if (it == files.end())
+    {
+        return;
+    }
+    formatSlow(it->second.buffer, record);
+    writeFile(it->first, it->second);
+}
+
+void AccessLog::write(const ServerConfig& serverConfig, const AccessLogEntry& entry)
+{
+    if (serverConfig.access_log.empty())
+    {
+        return;
+    }
+    std::map<std::string, File>::iterator it = files.find(serverConfig.access_log);
+    if (it == files.end())
+    {
+        return;
+    }
+
+    if (serverConfig.access_log_json)
+        formatJson(it->second.buffer, entry);
+    else
+        formatCombined(it->second.buffer, entry);
+
+    if (it->second.buffer.size() >= ACCESS_LOG_BUFFER_SIZE)
+    {
+        writeFile(it->first, it->second);
+    }
+}
+
+// Sans force, les tampons ne sont écrits qu'une fois ACCESS_LOG_FLUSH_INTERVAL écoulé depuis le dernier vidage
+void AccessLog::flush(bool force)
+{
+    std::time_t now = Clock::getInstance().now();
+    if (!force && now - lastFlush < ACCESS_LOG_FLUSH_INTERVAL)
+    {
+        return;
+    }
+    lastFlush = now;
+
+    for (std::map<std::string, File>::iterator it = files.begin(); it != files.end(); ++it)
+    {
+        writeFile(it->first, it->second);
+    }
+}
+
+// SIGUSR1 : après un logrotate, les fichiers sont rouverts sous leur nom d'origine
+void AccessLog::reopen()
+{
+    for (std::map<std::string, File>::iterator it = files.begin(); it != files.end(); ++it)
+    {
+        writeFile(it->first, it->second);
+        if (it->second.fd >= 0)
+        {
+            close(it->second.fd);
+        }
+        it->second.fd = openFile(it->first, it->second.chrome, it->second.buffer);
+    }
+    lastFlush = Clock::getInstance().now();
+}
+
+bool AccessLog::hasPending() const
+{
+    for (std::map<std::string, File>::const_iterator it = files.begin(); it != files.end(); ++it)
+    {
+        if (!it->second.buffer.empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**************************************************************************
+ *                          METHODES PRIVEES                              *
+ * ***********************************************************************/
+
+void AccessLog::addFile(std::map<std::string, File>& next, const std::string& path, bool chrome)
+{
+    if (next.find(path) != next.end())
+    {
+        return;
+    }
+
+    std::map<std::string, File>::iterator it = files.find(path);
+    if (it != files.end())
+    {
+        next[path] = it->second;
+        files.erase(it);
+        return;
+    }
+
+    File file;
+    file.chrome = chrome;
+    file.fd = openFile(path, chrome, file.buffer);
+    if (file.fd >= 0)
+    {
+        next[path] = file;
+        LOG_INFO("Journal d'accès ouvert : " + path);
+    }
+}
+
+// Un fichier de traces Chrome est un tableau JSON dont le crochet fermant est facultatif : il est ouvert s'il est vide
+int AccessLog::openFile(const std::string& path, bool chrome, std::string& buffer)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        LOG_ERROR("Impossible d'ouvrir le journal d'accès " + path + " : " + strerror(errno));
+    }
+    else if (chrome && lseek(fd, 0, SEEK_END) == 0 && buffer.empty())
+    {
+        buffer = "[\n";
+    }
+    return fd;
+}
+
+void AccessLog::writeFile(const std::string& path, File& file)
+{
+    size_t written = 0;
+    while (file.fd >= 0 && written < file.buffer.size())
+    {
+        ssize_t result = ::write(file.fd, file.buffer.data() + written, file.buffer.size() - written);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            LOG_ERROR("Écriture impossible dans le journal d'accès " + path + ", lignes perdues.");
+            break;
+        }
+        written += result;
+    }
+    file.buffer.clear();
+}
+
+// Format "combined" d'Apache/nginx suivi du serveur virtuel et des mesures : rt (requête), ut (CGI), reqs (rang sur la connexion)
+void AccessLog::formatCombined(std::string& output, const AccessLogEntry& entry)
+{
+    char numbers[64];
+    output += entry.remoteAddress.empty() ? "-" : entry.remoteAddress;
+    output += " - - [";
+    output += Clock::getInstance().commonLogTime();
+    output += "] \"";
+    appendQuoted(output, entry.method + " " + entry.uri + " " + entry.httpVersion);
+    std::sprintf(numbers, "\" %d %lu \"", entry.status, static_cast<unsigned long>(entry.bytesSent));
+    output += numbers;
+    appendQuoted(output, entry.referer.empty() ? "-" : entry.referer);
+    output += "\" \"";
+    appendQuoted(output, entry.userAgent.empty() ? "-" : entry.userAgent);
+    output += "\" \"";
+    appendQuoted(output, entry.vhost.empty() ? "-" : entry.vhost);
+    output += "\" rt=";
+    appendSeconds(output, entry.requestTime);
+    output += " ut=";
+    if (entry.upstreamTime < 0)
+        output += "-";
+    else
+        appendSeconds(output, entry.upstreamTime);
+    std::sprintf(numbers, " reqs=%d\n", entry.requests);
+    output += numbers;
+}
+
+void AccessLog::formatJson(std::string& output, const AccessLogEntry& entry)
+{
+    char numbers[64];
+    output += "{\"time\":\"";
+    output += Clock::getInstance().isoTime();
+    output += "\",\"remote_addr\":";
+    appendJsonString(output, entry.remoteAddress);
+    output += ",\"vhost\":";
+    appendJsonString(output, entry.vhost);
+    output += ",\"method\":";
+    appendJsonString(output, entry.method);
+    output += ",\"uri\":";
+    appendJsonString(output, entry.uri);
+    output += ",\"protocol\":";
+    appendJsonString(output, entry.httpVersion);
+    std::sprintf(numbers, ",\"status\":%d,\"bytes_sent\":%lu,\"request_time\":", entry.status, static_cast<unsigned long>(entry.bytesSent));
+    output += numbers;
+    appendSeconds(output, entry.requestTime);
+    output += ",\"upstream_time\":";
+    if (entry.upstreamTime < 0)
+        output += "null";
+    else
+        appendSeconds(output, entry.upstreamTime);
+    std::sprintf(numbers, ",\"connection_requests\":%d,\"referer\":", entry.requests);
+    output += numbers;
+    appendJsonString(output, entry.referer);
+    output += ",\"user_agent\":";
+    appendJsonString(output, entry.userAgent);
+    output += "}\n";
+}
+
+// Ligne "combined" raccourcie suivie des bornes atteintes, en microsecondes depuis la réception du premier octet
+void AccessLog::formatTrace(std::string& output, const TraceRecord& record)
+{
+    char numbers[64];
+    long origin = record.trace.marks[RequestTrace::RECEIVED];
+    output += record.remoteAddress.empty() ? "-" : record.remoteAddress;
+    output += " - - [";
+    output += Clock::getInstance().commonLogTime();
+    output += "] \"";
+    appendQuoted(output, record.method + " " + record.uri + " " + record.httpVersion);
+    std::sprintf(numbers, "\" %d trace_us=", record.status);
+    output += numbers;
+    const char* separator = "";
+    for (int i = RequestTrace::PARSED; i < RequestTrace::PHASE_COUNT; ++i)
+    {
+        if (record.trace.marks[i] < 0)
+        {
+            continue;
+        }
+        std::sprintf(numbers, "%s%s:%ld", separator, PHASE_NAMES[i], record.trace.marks[i] - origin);
+        output += numbers;
+        separator = ",";
+    }
+    output += '\n';
+}
+
+void AccessLog::formatTraceJson(std::string& output, const TraceRecord& record)
+{
+    char numbers[64];
+    long origin = record.trace.marks[RequestTrace::RECEIVED];
+    output += "{\"time\":\"";
+    output += Clock::getInstance().isoTime();
+    output += "\",\"remote_addr\":";
+    appendJsonString(output, record.remoteAddress);
+    output += ",\"method\":";
+    appendJsonString(output, record.method);
+    output += ",\"uri\":";
+    appendJsonString(output, record.uri);
+    output += ",\"protocol\":";
+    appendJsonString(output, record.httpVersion);
+    std::sprintf(numbers, ",\"status\":%d,\"trace_us\":{", record.status);
+    output += numbers;
+    const char* separator = "";
+    for (int i = RequestTrace::PARSED; i < RequestTrace::PHASE_COUNT; ++i)
+    {
+        if (record.trace.marks[i] < 0)
+        {
+            continue;
+        }
+        std::sprintf(numbers, "%s\"%s\":%ld", separator, PHASE_NAMES[i], record.trace.marks[i] - origin);
+        output += numbers;
+        separator = ",";
+    }
+    output += "}}\n";
+}
+
+// Un événement "X" pour la requête entière puis un par intervalle dont les deux bornes sont connues, sur la piste du descripteur
+void AccessLog::formatChromeTrace(std::string& output, const TraceRecord& record)
+{
+    char event[160];
+    const long* marks = record.trace.marks;
+    int pid = static_cast<int>(getpid());
+
+    std::sprintf(event, "{\"name\":\"request\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%ld,\"dur\":%ld,\"args\":{\"request\":",
+        pid, record.fd, marks[RequestTrace::RECEIVED], marks[RequestTrace::LAST_BYTE] - marks[RequestTrace::RECEIVED]);
+    output += event;
+    appendJsonString(output, record.method + " " + record.uri);
+    output += ",\"client\":";
+    appendJsonString(output, record.remoteAddress);
+    std::sprintf(event, ",\"status\":%d}},\n", record.status);
+    output += event;
+
+    for (size_t i = 0; i < sizeof(CHROME_SPANS) / sizeof(CHROME_SPANS[0]); ++i)
+    {
+        long from = marks[CHROME_SPANS[i].from];
+        long to = marks[CHROME_SPANS[i].to];
+        if (from < 0 || to < 0)
+        {
+            continue;
+        }
+        std::sprintf(event, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%ld,\"dur\":%ld},\n",
+            CHROME_SPANS[i].name, pid, record.fd, from, to - from);
+        output += event;
+    }
+}
+
+// Un bloc par requête à la manière du slow log de MySQL : en-tête commenté, ligne de requête puis en-têtes reçus.
+// Les valeurs d'authentification et de cookies sont masquées
+void AccessLog::formatSlow(std::string& output, const TraceRecord& record)
+{
+    char numbers[64];
+    long origin = record.trace.marks[RequestTrace::RECEIVED];
+
+    output += "# Time: ";
+    output += Clock::getInstance().isoTime();
+    output += "\n# Client: ";
+    output += record.remoteAddress.empty() ? "-" : record.remoteAddress;
+    output += "  Vhost: ";
+    appendQuoted(output, record.vhost.empty() ? "-" : record.vhost);
+    std::sprintf(numbers, "  Status: %d  Duration: ", record.status);
+    output += numbers;
+    appendSeconds(output, (record.trace.marks[RequestTrace::LAST_BYTE] - origin) / 1e6);
+    output += " s\n";
+    if (!record.trace.script.empty())
+    {
+        output += "# Script: ";
+        appendQuoted(output, record.trace.script);
+        output += '\n';
+    }
+    output += "# Phases (us):";
+    for (int i = RequestTrace::PARSED; i < RequestTrace::PHASE_COUNT; ++i)
+    {
+        if (record.trace.marks[i] >= 0)
+        {
+            std::sprintf(numbers, " %s=%ld", PHASE_NAMES[i], record.trace.marks[i] - origin);
+            output += numbers;
+        }
+    }
+    output += '\n';
+
+    appendQuoted(output, record.method + " " + record.uri + " " + record.httpVersion);
+    output += '\n';
+    for (std::map<std::string, std::string>::const_iterator it = record.headers.begin(); it != record.headers.end(); ++it)
+    {
+        appendQuoted(output, it->first);
+        output += ": ";
+        if (strcasecmp(it->first.c_str(), "Authorization") == 0 || strcasecmp(it->first.c_str(), "Proxy-Authorization") == 0
+            || strcasecmp(it->first.c_str(), "Cookie") == 0)
+            output += "[masqué]";
+        else
+            appendQuoted(output, it->second);
+        output += '\n';
+    }
+    output += '\n';
+}
+
+// Guillemets et caractères de contrôle sont échappés comme le fait nginx (\x22)
+void AccessLog::appendQuoted(std::string& output, const std::string& value)
+{
+    char escaped[8];
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c == '"' || c == '\\' || c < 0x20 || c == 0x7f)
+        {
+            std::sprintf(escaped, "\\x%02X", c);
+            output += escaped;
+        }
+        else
+        {
+            output += static_cast<char>(c);
+        }
+    }
+}
+
+void AccessLog::appendJsonString(std::string& output, const std::string& value)
+{
+    char escaped[8];
+    output += '"';
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c == '"' || c == '\\')
+        {
+            output += '\\';
+            output += static_cast<char>(c);
+        }
+        else if (c < 0x20)
+        {
+            std::sprintf(escaped, "\\u%04x", c);
+            output += escaped;
+        }
+        else
+        {
+            output += static_cast<char>(c);
+        }
+    }
+    output += '"';
+}
+
+void AccessLog::appendSeconds(std::string& output, double seconds)
+{
+    char buffer[32];
+    std::sprintf(buffer, "%.3f", seconds);
+    output += buffer;
+}
@@ -0,0 +1,202 @@
+#include "../includes/CgiCache.hpp"
+
+CgiCache::CgiCache(size_t maxSize, int maxTtl)
+: currentSize(0), maxSize(maxSize), maxTtl(maxTtl)
+{
+}
+
+CgiCache::~CgiCache()
+{
+    entries.clear();
+    lru.clear();
+}
+
+/**************************************************************************
+ *                          METHODES PUBLIQUES                            *
+ * ***********************************************************************/
+
+std::string CgiCache::buildKey(const HttpRequest& request, const std::vector<std::string>& keyHeaders) const
+{
+    std::string key = request.method + " " + request.uri;
+
+    for (size_t i = 0; i < keyHeaders.size(); ++i)
+    {
+        key += "\n" + keyHeaders[i] + ": " + request.getHeader(keyHeaders[i]);
+    }
+    return key;
+}
+
+bool CgiCache::lookup(const std::string& key, HttpResponse& response)
+{
+    std::map<std::string, Entry>::iterator it = entries.find(key);
+    if (it == entries.end())
+    {
+        return false;
+    }
+
+    if (it->second.expiresAt <= std::time(0))
+    {
+        LOG_INFO("Entrée du cache CGI expirée : " + key);
+        remove(it);
+        return false;
+    }
+
+    // L'entrée la plus récemment servie passe en tête de la liste LRU
+    lru.splice(lru.begin(), lru, it->second.lruPosition);
+    response = it->second.response;
+    return true;
+}
+
+void CgiCache::store(const std::string& key, const HttpResponse& response)
+{
+    std::time_t now = std::time(0);
+    int ttl = computeTtl(response, now);
+    if (ttl <= 0)
+    {
+        LOG_INFO("Réponse CGI non cachable : " + key);
+        return;
+    }
+    if (maxTtl > 0 && ttl > maxTtl)
+    {
+        ttl = maxTtl;
+    }
+
+    size_t size = entrySize(key, response);
+    if (size > maxSize)
+    {
+        LOG_INFO("Réponse CGI trop volumineuse pour le cache : " + key);
+        return;
+    }
+
+    std::map<std::string, Entry>::iterator existing = entries.find(key);
+    if (existing != entries.end())
+    {
+        remove(existing);
+    }
+
+    while (currentSize + size > maxSize && !lru.empty())
+    {
+        remove(entries.find(lru.back()));
+    }
+
+    lru.push_front(key);
+    Entry& entry = entries[key];
+    entry.response = response;
+    entry.expiresAt = now + ttl;
+    entry.size = size;
+    entry.lruPosition = lru.begin();
+    currentSize += size;
+
+    LOG_INFO_STREAM("Réponse CGI mise en cache pour " << ttl << "s : " << key);
+}
+
+// Renvoie la durée de vie en secondes autorisée par le script, ou -1 si la réponse ne doit pas être cachée
+int CgiCache::computeTtl(const HttpResponse& response, std::time_t now)
+{
+    std::string status = findHeader(response, "Status");
+    if (!status.empty() && status.compare(0, 3, "200") != 0)
+    {
+        return -1;
+    }
+
+    std::string cacheControl = findHeader(response, "Cache-Control");
+    for (size_t i = 0; i < cacheControl.size(); ++i)
+    {
+        cacheControl[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(cacheControl[i])));
+    }
+
+    int maxAge = -1;
+    int sharedMaxAge = -1;
+    std::istringstream directives(cacheControl);
+    std::string directive;
+    while (std::getline(directives, directive, ','))
+    {
+        std::string::size_type first = directive.find_first_not_of(" \t");
+        if (first == std::string::npos)
+        {
+            continue;
+        }
+        directive = directive.substr(first, directive.find_last_not_of(" \t") - first + 1);
+
+        if (directive == "no-store" || directive == "no-cache" || directive == "private")
+        {
+            return -1;
+        }
+        if (directive.compare(0, 8, "max-age=") == 0)
+        {
+            maxAge = std::atoi(directive.c_str() + 8);
+        }
+        else if (directive.compare(0, 9, "s-maxage=") == 0)
+        {
+            sharedMaxAge = std::atoi(directive.c_str() + 9);
+        }
+    }
+
+    if (sharedMaxAge >= 0)
+    {
+        return sharedMaxAge;
+    }
+    if (maxAge >= 0)
+    {
+        return maxAge;
+    }
+
+    std::string expires = findHeader(response, "Expires");
+    if (!expires.empty())
+    {
+        struct tm tm;
+        std::memset(&tm, 0, sizeof(tm));
+        if (strptime(expires.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm) == NULL)
+        {
+            return -1;
+        }
+        std::time_t expiresAt = timegm(&tm);
+        return expiresAt > now ? static_cast<int>(expiresAt - now) : -1;
+    }
+
+    return -1;
+}
+
+/**************************************************************************
+ *                          METHODES PRIVEES                              *
+ * ***********************************************************************/
+
+void CgiCache::remove(std::map<std::string, Entry>::iterator it)
+{
+    currentSize -= it->second.size;
+    lru.erase(it->second.lruPosition);
+    entries.erase(it);
+}
+
+size_t CgiCache::entrySize(const std::string& key, const HttpResponse& response)
+{
+    size_t size = key.size() + response.body.size();
+
+    for (std::map<std::string, std::string>::const_iterator it = response.headers.begin(); it != response.headers.end(); ++it)
+    {
+        size += it->first.size() + it->second.size();
+    }
+    return size;
+}
+
+std::string CgiCache::findHeader(const HttpResponse& response, const std::string& name)
+{
+    for (std::map<std::string, std::string>::const_iterator it = response.headers.begin(); it != response.headers.end(); ++it)
+    {
+        if (it->first.size() != name.size())
+        {
+            continue;
+        }
+
+        size_t i = 0;
+        while (i < name.size() && std::tolower(static_cast<unsigned char>(it->first[i])) == std::tolower(static_cast<unsigned char>(name[i])))
+        {
+            ++i;
+        }
+        if (i == name.size())
+        {
+            return it->second;
+        }
+    }
+    return "";
+}
@@ -76,10 +76,10 @@ HttpResponse CgiHandler::executeScript()
     }
     else
     {
+        handler.markTrace(RequestTrace::CGI_SPAWN);
         close(outputPipefd[1]);
         close(inputPipefd[0]);
 
-        std::ostringstream ss;
         if (!request.body.empty())
         {
             ssize_t written = write(inputPipefd[1], request.body.c_str(), request.body.size());
@@ -89,9 +89,7 @@ HttpResponse CgiHandler::executeScript()
             }
             else
             {
-                ss << "Écriture de " << written << " octets dans le pipe d'entrée.";
-                LOG_INFO(ss.str());
-                ss.str("");
+                LOG_INFO_STREAM("Écriture de " << written << " octets dans le pipe d'entrée.");
             }
         }
         close(inputPipefd[1]);
@@ -105,11 +103,11 @@ HttpResponse CgiHandler::executeScript()
             output += buffer;
         }
         close(outputPipefd[0]);
-        ss << "Lecture de la sortie du script CGI terminée. Taille des données : " << output.size() << " octets.";
-        LOG_INFO(ss.str());
+        LOG_INFO_STREAM("Lecture de la sortie du script CGI terminée. Taille des données : " << output.size() << " octets.");
 
         int status;
         waitpid(pid, &status, 0);
+        handler.markTrace(RequestTrace::CGI_EXIT);
         if (WIFEXITED(status) && WEXITSTATUS(status) != EXIT_SUCCESS) {
             // Ici, vous savez que execve a échoué
             HttpResponse errorResponse;
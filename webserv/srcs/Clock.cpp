@@ -0,0 +1,95 @@
+#include "../includes/Clock.hpp"
+
+Clock& Clock::getInstance()
+{
+    static Clock instance;
+
+    return instance;
+}
+
+Clock::Clock() : formattedSecond(-1)
+{
+    update();
+}
+
+Clock::~Clock()
+{
+}
+
+/**************************************************************************
+ *                          METHODES PUBLIQUES                            *
+ * ***********************************************************************/
+
+void Clock::update()
+{
+    gettimeofday(&current, NULL);
+    if (current.tv_sec != formattedSecond)
+    {
+        format();
+    }
+}
+
+std::time_t Clock::now() const
+{
+    return current.tv_sec;
+}
+
+const struct timeval& Clock::precise() const
+{
+    return current;
+}
+
+// Format IMF-fixdate de l'en-tête Date (RFC 9110), toujours en GMT
+const std::string& Clock::httpDate() const
+{
+    return httpDateText;
+}
+
+// Horodatage des lignes de server.log
+const std::string& Clock::logTime() const
+{
+    return logTimeText;
+}
+
+// Horodatage du format "combined" du journal d'accès
+const std::string& Clock::commonLogTime() const
+{
+    return commonLogTimeText;
+}
+
+const std::string& Clock::isoTime() const
+{
+    return isoTimeText;
+}
+
+// Microsecondes depuis un instant arbitraire, insensibles aux corrections de l'heure système
+long Clock::monotonic()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000L + now.tv_nsec / 1000;
+}
+
+/**************************************************************************
+ *                          METHODES PRIVEES                              *
+ * ***********************************************************************/
+
+void Clock::format()
+{
+    char buffer[64];
+    struct tm utc;
+    struct tm local;
+
+    formattedSecond = current.tv_sec;
+    gmtime_r(&formattedSecond, &utc);
+    localtime_r(&formattedSecond, &local);
+
+    std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &utc);
+    httpDateText = buffer;
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+    logTimeText = buffer;
+    std::strftime(buffer, sizeof(buffer), "%d/%b/%Y:%H:%M:%S %z", &local);
+    commonLogTimeText = buffer;
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S%z", &local);
+    isoTimeText = buffer;
+}
@@ -1,7 +1,16 @@
 #include "../includes/ConfigParser.hpp"
 
+// Profondeur maximale des directives include imbriquées (protège contre les inclusions circulaires)
+static const int MAX_INCLUDE_DEPTH = 16;
+
+// Analyse seule, sans toucher au journal : utilisé par "webserv -t"
+ConfigParser::ConfigParser(const std::string& filename)
+: filename(filename), cursor(0)
+{
+}
+
 ConfigParser::ConfigParser(const std::string& filename, const std::string& logFile, Logger::Level logLevel)
-: filename(filename), serverCount(0)
+: filename(filename), cursor(0)
 {
     Logger& logger = Logger::getInstance();
     logger.configure(logFile, logLevel);
@@ -10,6 +19,7 @@ ConfigParser::ConfigParser(const std::string& filename, const std::string& logFi
 ConfigParser::~ConfigParser()
 {
     servers.clear();
+    locationConfigs.clear();
 }
 
 ConfigParser& ConfigParser::operator=(const ConfigParser& other)
@@ -18,8 +28,10 @@ ConfigParser& ConfigParser::operator=(const ConfigParser& other)
     {
         filename = other.filename;
         servers = other.servers;
-        serverCount = other.serverCount;
-        iss.str(other.iss.str());
+        locationConfigs = other.locationConfigs;
+        sourceFiles = other.sourceFiles;
+        tokens.clear();
+        cursor = 0;
     }
     return *this;
 }
@@ -29,370 +41,764 @@ const std::vector<ServerConfig>& ConfigParser::getServers() const
     return servers;
 }
 
+// Configurations effectives des blocs location, désignées par LocationConfig::configIndex
+const std::vector<ServerConfig>& ConfigParser::getLocationConfigs() const
+{
+    return locationConfigs;
+}
+
+// Le fichier (et ses inclusions) est d'abord découpé en jetons, puis analysé ; toute erreur lève une
+// std::runtime_error de la forme "fichier:ligne:colonne: message"
 void ConfigParser::parse()
 {
-    LOG_INFO("Tentative d'ouverture du fichier de configuration : " + filename);
+    LOG_INFO("Analyse du fichier de configuration : " + filename);
 
-    std::ifstream configFile(filename.c_str());
-    if (!configFile.is_open())
-    {
-        throw std::runtime_error("Could not open config file.");
-    }
+    servers.clear();
+    locationConfigs.clear();
+    sourceFiles.clear();
+    tokens.clear();
+
+    tokenizeFile(filename, 0, NULL);
 
-    std::string line;
-    int serverBlockCount = 0;
-    while (getline(configFile, line))
+    cursor = 0;
+    while (cursor < tokens.size())
     {
-        trim(line);
-        if (line.empty() || line[0] == '#')
+        const Token& token = tokens[cursor++];
+
+        if (token.type == Token::BLOCK_START && token.key == "server")
         {
-            continue;
+            parseServerBlock(token);
         }
-
-        if (line == "server {")
+        else if (token.type == Token::BLOCK_END)
+        {
+            error(token, "'}' sans bloc ouvert");
+        }
+        else if (token.type == Token::BLOCK_START)
         {
-            LOG_INFO("Début de l'analyse d'un bloc 'server'.");
-            ServerConfig serverConfig;
-            parseServerBlock(configFile, serverConfig);
-            servers.push_back(serverConfig);
-            serverBlockCount++;
-            
-            std::ostringstream msg;
-            msg << "Fin de l'analyse du bloc 'server' #" << serverBlockCount << ".";
-            LOG_INFO(msg.str());
+            error(token, "bloc '" + token.key + "' inattendu en dehors d'un bloc 'server'");
         }
         else
         {
-            std::ostringstream msg;
-            msg << "Ligne inattendue en dehors d'un bloc 'server' : " << line;
-            LOG_WARNING(msg.str());
+            error(token, "directive '" + token.key + "' inattendue en dehors d'un bloc 'server'");
         }
     }
+    tokens.clear();
 
-    if (serverBlockCount == 0)
+    if (servers.empty())
     {
         LOG_WARNING("Aucun bloc 'server' trouvé dans le fichier de configuration.");
     }
     else
     {
         std::ostringstream msg;
-        msg << "Nombre total de blocs 'server' analysés : " << serverBlockCount;
+        msg << "Nombre total de blocs 'server' analysés : " << servers.size();
         LOG_INFO(msg.str());
     }
+}
 
-    configFile.close();
-    LOG_INFO("Analyse du fichier de configuration terminée.");
+/**************************************************************************
+ *                          DECOUPAGE EN JETONS                           *
+ * ***********************************************************************/
+
+void ConfigParser::tokenizeFile(const std::string& path, int depth, const Token* includedFrom)
+{
+    std::ifstream configFile(path.c_str(), std::ios::in | std::ios::binary);
+    if (!configFile.is_open())
+    {
+        if (includedFrom)
+        {
+            error(*includedFrom, "impossible d'ouvrir le fichier inclus " + path);
+        }
+        throw std::runtime_error("Could not open config file: " + path);
+    }
+
+    // Lecture du fichier en une fois : le découpage travaille ensuite directement sur le tampon
+    std::string content;
+    configFile.seekg(0, std::ios::end);
+    std::streamoff size = configFile.tellg();
+    if (size > 0)
+    {
+        content.resize(static_cast<size_t>(size));
+        configFile.seekg(0, std::ios::beg);
+        configFile.read(&content[0], size);
+    }
+
+    sourceFiles.push_back(path);
+    size_t fileIndex = sourceFiles.size() - 1;
+
+    const char* current = content.data();
+    const char* end = current + content.size();
+    int line = 1;
+    while (current < end)
+    {
+        const char* eol = static_cast<const char*>(memchr(current, '\n', end - current));
+        if (!eol)
+        {
+            eol = end;
+        }
+        tokenizeLine(current, eol, fileIndex, line, depth);
+        current = eol + 1;
+        ++line;
+    }
 }
 
-void ConfigParser::parseServerBlock(std::ifstream& configFile, ServerConfig& serverConfig)
+void ConfigParser::tokenizeLine(const char* begin, const char* end, size_t fileIndex, int line, int depth)
 {
-    std::string line;
+    const char* start = begin;
+    while (start < end && (*start == ' ' || *start == '\t'))
+    {
+        ++start;
+    }
+    while (end > start && std::isspace(static_cast<unsigned char>(end[-1])))
+    {
+        --end;
+    }
+    if (start == end || *start == '#')
+    {
+        return;
+    }
 
-    while (getline(configFile, line))
+    Token token;
+    token.fileIndex = fileIndex;
+    token.line = line;
+    token.column = static_cast<int>(start - begin) + 1;
+
+    if (end - start == 1 && *start == '}')
     {
-        trim(line);
+        token.type = Token::BLOCK_END;
+        tokens.push_back(token);
+        return;
+    }
 
-        if (line.empty())
+    if (end[-1] == '{')
+    {
+        const char* headerEnd = end - 1;
+        while (headerEnd > start && std::isspace(static_cast<unsigned char>(headerEnd[-1])))
         {
-            continue;
+            --headerEnd;
         }
+        token.type = Token::BLOCK_START;
+        token.key.assign(start, headerEnd);
+        tokens.push_back(token);
+        return;
+    }
+
+    const char* colon = static_cast<const char*>(memchr(start, ':', end - start));
+    if (!colon)
+    {
+        token.type = Token::DIRECTIVE;
+        token.key.assign(start, end);
+        error(token, "':' attendu après '" + token.key + "'");
+    }
 
-        if (line[0] == '#')
+    const char* keyEnd = colon;
+    while (keyEnd > start && std::isspace(static_cast<unsigned char>(keyEnd[-1])))
+    {
+        --keyEnd;
+    }
+    const char* valueStart = colon + 1;
+    while (valueStart < end && std::isspace(static_cast<unsigned char>(*valueStart)))
+    {
+        ++valueStart;
+    }
+    // Un ';' final, hérité de la syntaxe nginx, est toléré
+    const char* valueEnd = end;
+    if (valueEnd > valueStart && valueEnd[-1] == ';')
+    {
+        --valueEnd;
+        while (valueEnd > valueStart && std::isspace(static_cast<unsigned char>(valueEnd[-1])))
         {
+            --valueEnd;
+        }
+    }
+
+    token.type = Token::DIRECTIVE;
+    token.key.assign(start, keyEnd);
+    token.value.assign(valueStart, valueEnd);
+    if (token.key.empty())
+    {
+        error(token, "nom de directive manquant");
+    }
+
+    if (token.key == "include")
+    {
+        expandInclude(token, depth);
+        return;
+    }
+    tokens.push_back(token);
+}
+
+// Les chemins relatifs sont résolus depuis le dossier du fichier qui contient la directive include
+void ConfigParser::expandInclude(const Token& token, int depth)
+{
+    if (depth >= MAX_INCLUDE_DEPTH)
+    {
+        error(token, "inclusions trop imbriquées (inclusion circulaire ?)");
+    }
+    if (token.value.empty())
+    {
+        error(token, "chemin attendu après 'include'");
+    }
+
+    std::string pattern = token.value;
+    if (pattern[0] != '/')
+    {
+        const std::string& current = sourceFiles[token.fileIndex];
+        std::string::size_type slash = current.find_last_of('/');
+        if (slash != std::string::npos)
+        {
+            pattern = current.substr(0, slash + 1) + pattern;
+        }
+    }
+
+    glob_t matches;
+    int status = glob(pattern.c_str(), 0, NULL, &matches);
+    if (status == GLOB_NOMATCH)
+    {
+        globfree(&matches);
+        if (pattern.find_first_of("*?[") == std::string::npos)
+        {
+            error(token, "fichier inclus introuvable : " + pattern);
+        }
+        LOG_WARNING(locate(token) + ": aucun fichier ne correspond à " + pattern);
+        return;
+    }
+    if (status != 0)
+    {
+        globfree(&matches);
+        error(token, "impossible de développer " + pattern);
+    }
+
+    std::vector<std::string> paths(matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+    globfree(&matches);
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        tokenizeFile(paths[i], depth + 1, &token);
+    }
+}
+
+/**************************************************************************
+ *                          ANALYSE DES BLOCS                             *
+ * ***********************************************************************/
+
+void ConfigParser::parseServerBlock(const Token& opening)
+{
+    ServerConfig serverConfig;
+    std::vector<std::vector<Token> > locationTokens;
+
+    while (true)
+    {
+        if (cursor >= tokens.size())
+        {
+            error(opening, "bloc 'server' non fermé");
+        }
+
+        const Token& token = tokens[cursor++];
+        if (token.type == Token::BLOCK_END)
+        {
+            break;
+        }
+        if (token.type == Token::BLOCK_START)
+        {
+            if (token.key.compare(0, 8, "location") != 0)
+            {
+                error(token, "bloc '" + token.key + "' inattendu dans un bloc 'server'");
+            }
+            parseLocationBlock(token, serverConfig, locationTokens);
             continue;
         }
+        applyDirective(token, serverConfig);
+    }
+
+    validateServer(opening, serverConfig);
+
+    // Les directives du serveur peuvent suivre les blocs location : l'héritage n'est résolu qu'une fois le bloc fermé
+    for (size_t i = 0; i < serverConfig.locations.size(); ++i)
+    {
+        serverConfig.locations[i].configIndex = locationConfigs.size();
+        locationConfigs.push_back(buildLocationConfig(serverConfig, locationTokens[i]));
+    }
+    servers.push_back(serverConfig);
+
+    std::ostringstream msg;
+    msg << "Bloc 'server' #" << servers.size() << " analysé (" << serverConfig.host << ":" << serverConfig.port
+        << ", " << serverConfig.locations.size() << " location(s)).";
+    LOG_INFO(msg.str());
+}
+
+void ConfigParser::parseLocationBlock(const Token& opening, ServerConfig& serverConfig, std::vector<std::vector<Token> >& locationTokens)
+{
+    LocationConfig location;
+    parseLocationHeader(opening, location);
+
+    std::vector<Token> directives;
+    while (true)
+    {
+        if (cursor >= tokens.size())
+        {
+            error(opening, "bloc 'location' non fermé");
+        }
 
-        if (line == "}")
+        const Token& token = tokens[cursor++];
+        if (token.type == Token::BLOCK_END)
         {
             break;
         }
-        else
+        if (token.type == Token::BLOCK_START)
         {
-            LOG_INFO("Analyse de la configuration du serveur : " + line);
-            parseKeyValue(line, serverConfig);
+            error(token, "les blocs imbriqués dans une location ne sont pas pris en charge");
         }
+        directives.push_back(token);
     }
 
-    LOG_INFO("Fin de l'analyse du bloc 'server'.");
+    location.configIndex = 0;
+    serverConfig.locations.push_back(location);
+    locationTokens.push_back(directives);
 }
 
-void ConfigParser::parseKeyValue(const std::string& line, ServerConfig& serverConfig)
+// Syntaxe : "location /prefixe {", "location = /chemin/exact {" ou "location ~ .ext {"
+void ConfigParser::parseLocationHeader(const Token& token, LocationConfig& location) const
 {
-    std::istringstream iss(line);
-    std::string key, rest;
-    getline(iss, key, ':');
-    getline(iss, rest);
-    trim(key);
-    trim(rest);
-    removeQuotes(rest);
+    std::vector<std::string> words;
+    splitWords(token.key, " \t", words);
 
-    LOG_INFO("Clé traitée: " + key);
+    if (words.size() == 3 && (words[1] == "=" || words[1] == "~"))
+    {
+        location.match = (words[1] == "=") ? LOCATION_EXACT : LOCATION_EXTENSION;
+        location.path = words[2];
+    }
+    else if (words.size() == 2 && words[0] == "location")
+    {
+        location.match = LOCATION_PREFIX;
+        location.path = words[1];
+    }
+    else
+    {
+        error(token, "en-tête de location invalide : '" + token.key + "'");
+    }
 
-    if (key == "host")
+    if (location.match == LOCATION_EXTENSION && location.path[0] != '.')
     {
-        serverConfig.host = rest;
-        LOG_INFO("Host défini: " + rest);
+        error(token, "une location par extension doit commencer par '.'");
     }
-    else if (key == "port")
+    if (location.match != LOCATION_EXTENSION && location.path[0] != '/')
     {
-        serverConfig.port = atoi(rest.c_str());
-        LOG_INFO("Port défini: " + rest);
+        error(token, "le chemin d'une location doit commencer par '/'");
     }
-    else if (key == "server_name")
+}
+
+// La location hérite de tout le bloc server ; une directive de liste qu'elle redéfinit remplace la valeur héritée
+ServerConfig ConfigParser::buildLocationConfig(const ServerConfig& serverConfig, const std::vector<Token>& directives) const
+{
+    ServerConfig locationConfig = serverConfig;
+    locationConfig.locations.clear();
+
+    std::vector<std::string> overridden;
+    for (size_t i = 0; i < directives.size(); ++i)
     {
-        std::istringstream namesStream(rest);
-        std::string name;
-        while (namesStream >> name)
+        const std::string& key = directives[i].key;
+
+        if (key == "host" || key == "port" || key == "server_name" || key == "listen_backlog" || key == "accept_batch"
+            || key == "shutdown_timeout" || key == "max_connections_per_ip"
+            || key == "allowed_ips" || key == "denied_ips" || key == "log_overflow" || key.compare(0, 4, "tcp_") == 0)
         {
-            serverConfig.server_names.push_back(name);
-            LOG_INFO("Nom de serveur ajouté: " + name);
+            error(directives[i], "la directive '" + key + "' n'est pas autorisée dans une location");
         }
+
+        if (std::find(overridden.begin(), overridden.end(), key) == overridden.end())
+        {
+            overridden.push_back(key);
+            if (key == "index")
+                locationConfig.index.clear();
+            else if (key == "allowed_methods")
+                locationConfig.allowed_methods.clear();
+            else if (key == "denied_methods")
+                locationConfig.denied_methods.clear();
+            else if (key == "cgi_ext")
+                locationConfig.cgi_ext.clear();
+            else if (key == "cgi_cache_key_headers")
+                locationConfig.cgi_cache_key_headers.clear();
+        }
+
+        applyDirective(directives[i], locationConfig);
     }
-    else if (key == "error_page")
+    return locationConfig;
+}
+
+void ConfigParser::validateServer(const Token& opening, const ServerConfig& serverConfig) const
+{
+    if (serverConfig.host.compare(0, 5, "unix:") == 0)
     {
-        serverConfig.error_page = rest;
-        LOG_INFO("Page d'erreur définie: " + rest);
+        return;
     }
-    else if (key == "client_max_body_size")
+    if (serverConfig.port <= 0)
     {
-        serverConfig.client_max_body_size = convertSizeToBytes(rest);
-        LOG_INFO("Taille maximale du corps client définie: " + rest);
+        error(opening, "directive 'port' manquante dans le bloc 'server'");
     }
-    else if (key == "root")
+}
+
+/**************************************************************************
+ *                              DIRECTIVES                                *
+ * ***********************************************************************/
+
+void ConfigParser::applyDirective(const Token& token, ServerConfig& serverConfig) const
+{
+    const std::string& key = token.key;
+    const std::string& value = token.value;
+
+    if (key == "host")
     {
-        serverConfig.root = rest;
-        LOG_INFO("Racine définie: " + rest);
+        serverConfig.host = value;
     }
-    else if (key == "index")
+    else if (key == "port")
     {
-        std::istringstream indexStream(rest);
-        std::string pageIndex;
-        while (indexStream >> pageIndex)
+        serverConfig.port = parseInteger(token);
+        if (serverConfig.port < 1 || serverConfig.port > 65535)
         {
-            serverConfig.index.push_back(pageIndex);
-            LOG_INFO("Page d'index ajoutée: " + pageIndex);
+            error(token, "port hors de l'intervalle 1-65535 : " + value);
         }
     }
-    else if (key == "allowed_ips")
+    else if (key == "server_name")
     {
-        std::istringstream ipsStream(rest);
-        std::string ip;
-        while (ipsStream >> ip)
-        {
-            serverConfig.allowed_ips.push_back(ip);
-            LOG_INFO("IP autorisée ajoutée: " + ip);
-        }
+        splitWords(value, " \t", serverConfig.server_names);
     }
-    else if (key == "denied_ips")
+    else if (key == "error_page")
     {
-        std::istringstream ipsStream(rest);
-        std::string ip;
-        while (ipsStream >> ip)
-        {
-            serverConfig.denied_ips.push_back(ip);
-            LOG_INFO("IP refusée ajoutée: " + ip);
-        }
+        serverConfig.error_page = value;
+    }
+    else if (key == "client_max_body_size")
+    {
+        serverConfig.client_max_body_size = parseSize(token);
     }
-    else if (key.substr(0, 4) == "cgi_")
+    else if (key == "root")
     {
+        serverConfig.root = value;
+    }
+    else if (key == "index")
+    {
+        splitWords(value, " \t", serverConfig.index);
+    }
+    else if (key == "allowed_ips" || key == "denied_ips")
+    {
+        std::vector<std::string>& networks = (key == "allowed_ips") ? serverConfig.allowed_ips : serverConfig.denied_ips;
+        size_t first = networks.size();
+        splitWords(value, ", \t", networks);
 
-        if (key == "cgi_bin")
-        {
-            serverConfig.cgi_bin = rest;
-        }
-        else if (key == "cgi_handler")
+        unsigned char address[16];
+        int prefixLength;
+        for (size_t i = first; i < networks.size(); ++i)
         {
-            size_t colonPos = rest.find(':');
-            if (colonPos != std::string::npos)
+            if (!AccessList::parseNetwork(networks[i], address, prefixLength))
             {
-                std::string ext = rest.substr(0, colonPos);
-                std::string handlerPath = rest.substr(colonPos + 1);
-                serverConfig.cgi_handlers[ext] = handlerPath;
+                error(token, "adresse ou réseau CIDR invalide : " + networks[i]);
             }
         }
-        else if (key == "cgi_ext")
-        {
-            std::istringstream extStream(rest);
-            std::string ext;
-            while (getline(extStream, ext, ','))
-            {
-                trim(ext);
-                serverConfig.cgi_ext.push_back(ext);
-            }
-        }
-        else
+    }
+    else if (key == "cgi_bin")
+    {
+        serverConfig.cgi_bin = value;
+    }
+    else if (key == "cgi_handler")
+    {
+        // Forme sur une ligne "cgi_handler: .py: /usr/bin/python3" ; sinon les extensions suivent sur leurs propres lignes
+        std::string::size_type colonPos = value.find(':');
+        if (colonPos != std::string::npos)
         {
-            std::vector<std::string>::iterator it = std::find(serverConfig.cgi_ext.begin(), serverConfig.cgi_ext.end(), key);
-            if (it != serverConfig.cgi_ext.end())
+            std::vector<std::string> ext, handlerPath;
+            splitWords(value.substr(0, colonPos), " \t", ext);
+            splitWords(value.substr(colonPos + 1), " \t", handlerPath);
+            if (ext.size() != 1 || handlerPath.size() != 1)
             {
-                serverConfig.cgi_handlers[key] = rest;
-            }
-            else
-            {
-                LOG_WARNING("Clé non reconnue ou non prise en charge: " + key);
+                error(token, "forme attendue : 'cgi_handler: .ext: /chemin/interpreteur'");
             }
+            serverConfig.cgi_handlers[ext[0]] = handlerPath[0];
         }
     }
-    else if (std::find(serverConfig.cgi_ext.begin(), serverConfig.cgi_ext.end(), key) != serverConfig.cgi_ext.end()) {
-
-        serverConfig.cgi_handlers[key] = rest;
+    else if (key == "cgi_ext")
+    {
+        splitWords(value, ", \t", serverConfig.cgi_ext);
     }
-    else if (key == "allowed_methods")
+    else if (key == "cgi_cache")
+    {
+        serverConfig.cgi_cache = parseSwitch(token);
+    }
+    else if (key == "cgi_cache_max_size")
+    {
+        serverConfig.cgi_cache_max_size = parseSize(token);
+    }
+    else if (key == "cgi_cache_ttl")
     {
-        std::istringstream methodsStream(rest);
-        std::string method;
-        while (getline(methodsStream, method, ','))
+        serverConfig.cgi_cache_ttl = parseInteger(token);
+    }
+    else if (key == "cgi_cache_key_headers")
+    {
+        splitWords(value, ", \t", serverConfig.cgi_cache_key_headers);
+    }
+    else if (key[0] == '.')
+    {
+        if (std::find(serverConfig.cgi_ext.begin(), serverConfig.cgi_ext.end(), key) == serverConfig.cgi_ext.end())
         {
-            trim(method);
-            serverConfig.allowed_methods.push_back(method);
-            LOG_INFO("Méthode autorisée ajoutée: " + method);
+            error(token, "extension CGI '" + key + "' absente de cgi_ext");
         }
+        serverConfig.cgi_handlers[key] = value;
+    }
+    else if (key == "allowed_methods")
+    {
+        splitWords(value, ", \t", serverConfig.allowed_methods);
     }
     else if (key == "denied_methods")
     {
-        std::istringstream methodsStream(rest);
-        std::string method;
-        while (getline(methodsStream, method, ','))
-        {
-            trim(method);
-            serverConfig.denied_methods.push_back(method);
-            LOG_INFO("Méthode refusée ajoutée: " + method);
-        }
+        splitWords(value, ", \t", serverConfig.denied_methods);
     }
     else if (key == "redirection")
     {
-        std::istringstream redirectStream(rest);
-        std::string from, to;
-        while (getline(redirectStream, from, ' ') && getline(redirectStream, to, ' '))
+        std::vector<std::string> words;
+        splitWords(value, " \t", words);
+        if (words.size() % 2 != 0)
+        {
+            error(token, "la redirection attend des paires 'source destination'");
+        }
+        for (size_t i = 0; i < words.size(); i += 2)
         {
-            serverConfig.redirections[from] = to;
-            LOG_INFO("Redirection configurée de " + from + " à " + to);
+            serverConfig.redirections[words[i]] = words[i + 1];
         }
     }
     else if (key == "route_specific_root")
     {
-        size_t delimPos = rest.find("->");
-        if (delimPos != std::string::npos)
+        std::string::size_type delimPos = value.find("->");
+        if (delimPos == std::string::npos)
         {
-            std::string uri = rest.substr(0, delimPos);
-            std::string path = rest.substr(delimPos + 2);
-            serverConfig.route_specific_root[uri] = path;
-            LOG_INFO("Chemin spécifique défini pour l'URI " + uri + ": " + path);
+            error(token, "forme attendue : 'route_specific_root: /uri->/chemin'");
         }
+        serverConfig.route_specific_root[value.substr(0, delimPos)] = value.substr(delimPos + 2);
     }
     else if (key == "directory_listing")
     {
-        serverConfig.directory_listing = (rest == "on" ? true : false);
-        LOG_INFO("Directory listing set to: " + rest);
+        serverConfig.directory_listing = parseSwitch(token);
     }
     else if (key == "generate_index_html")
     {
-        serverConfig.generate_index_html = (rest == "on" ? true : false);
-        LOG_INFO("Generation d'index HTML définie sur: " + rest);
+        serverConfig.generate_index_html = parseSwitch(token);
     }
-    else
+    else if (key == "upload_splice")
     {
-        LOG_WARNING("Clé non reconnue ou non prise en charge: " + key);
+        serverConfig.upload_splice = parseSwitch(token);
     }
-}
-
-void ConfigParser::resetISS(std::istringstream& iss, const std::string& newStr)
-{
-    iss.clear();
-    iss.str(newStr);
-}
-
-void ConfigParser::trim(std::string& str) const
-{
-    std::string::size_type first = str.find_first_not_of(" \t\n\r\f\v");
-    std::string::size_type last = str.find_last_not_of(" \t\n\r\f\v");
-
-    if (first == std::string::npos || last == std::string::npos)
+    else if (key == "upload_fsync")
+    {
+        if (value == "data")
+            serverConfig.upload_fsync = FSYNC_DATA;
+        else
+            serverConfig.upload_fsync = parseSwitch(token) ? FSYNC_ALWAYS : FSYNC_OFF;
+    }
+    else if (key == "listen_backlog")
+    {
+        serverConfig.listen_backlog = parseInteger(token);
+    }
+    else if (key == "tcp_defer_accept")
+    {
+        if (value == "on" || value == "off")
+            serverConfig.tcp_defer_accept = (value == "on") ? 1 : 0;
+        else
+            serverConfig.tcp_defer_accept = parseInteger(token);
+    }
+    else if (key == "tcp_fastopen")
+    {
+        serverConfig.tcp_fastopen = parseInteger(token);
+    }
+    else if (key == "tcp_nodelay")
+    {
+        serverConfig.tcp_nodelay = parseSwitch(token);
+    }
+    else if (key == "accept_batch")
+    {
+        serverConfig.accept_batch = parseInteger(token);
+    }
+    else if (key == "shutdown_timeout")
+    {
+        serverConfig.shutdown_timeout = parseInteger(token);
+    }
+    else if (key == "rate_limit")
+    {
+        serverConfig.rate_limit = parseInteger(token);
+    }
+    else if (key == "rate_limit_burst")
+    {
+        serverConfig.rate_limit_burst = parseInteger(token);
+    }
+    else if (key == "max_connections_per_ip")
+    {
+        serverConfig.max_connections_per_ip = parseInteger(token);
+    }
+    else if (key == "access_log")
+    {
+        serverConfig.access_log = value;
+    }
+    else if (key == "access_log_format")
+    {
+        if (value != "combined" && value != "json")
+        {
+            error(token, "'combined' ou 'json' attendu pour 'access_log_format' : " + value);
+        }
+        serverConfig.access_log_json = (value == "json");
+    }
+    else if (key == "log_overflow")
+    {
+        if (value != "drop" && value != "block")
+        {
+            error(token, "'drop' ou 'block' attendu pour 'log_overflow' : " + value);
+        }
+        serverConfig.log_overflow_block = (value == "block");
+    }
+    else if (key == "metrics")
+    {
+        serverConfig.metrics = parseSwitch(token);
+    }
+    else if (key == "status")
+    {
+        serverConfig.status = parseSwitch(token);
+    }
+    else if (key == "trace")
+    {
+        if (value == "off")
+            serverConfig.trace = TRACE_OFF;
+        else if (value == "log")
+            serverConfig.trace = TRACE_LOG;
+        else if (value == "chrome")
+            serverConfig.trace = TRACE_CHROME;
+        else
+            error(token, "'off', 'log' ou 'chrome' attendu pour 'trace' : " + value);
+    }
+    else if (key == "trace_file")
+    {
+        serverConfig.trace_file = value;
+    }
+    else if (key == "slow_log")
+    {
+        serverConfig.slow_log = (value == "off") ? "" : value;
+    }
+    else if (key == "slow_log_threshold")
     {
-        str.clear();
+        serverConfig.slow_log_threshold = parseInteger(token);
     }
     else
     {
-        str = str.substr(first, (last - first + 1));
+        error(token, "directive inconnue '" + key + "'");
     }
 }
 
-std::string ConfigParser::cleanValue(const std::string& value)
+void ConfigParser::splitWords(const std::string& value, const char* separators, std::vector<std::string>& words)
 {
-    std::string cleanedValue = value;
-    cleanedValue.erase(std::remove(cleanedValue.begin(), cleanedValue.end(), ';'), cleanedValue.end());
-    return cleanedValue;
+    std::string::size_type start = value.find_first_not_of(separators);
+    while (start != std::string::npos)
+    {
+        std::string::size_type end = value.find_first_of(separators, start);
+        words.push_back(value.substr(start, end == std::string::npos ? std::string::npos : end - start));
+        start = value.find_first_not_of(separators, end);
+    }
 }
 
-std::string ConfigParser::removeQuotes(const std::string& input) const
+int ConfigParser::parseInteger(const Token& token) const
 {
-    std::string result = input;
-    if (!result.empty() && (result[0] == '"' || result[0] == '\''))
-        result.erase(0, 1);
-
-    if (!result.empty() && (result[result.size() - 1] == '"' || result[result.size() - 1] == '\''))
-        result.erase(result.size() - 1);
+    const std::string& value = token.value;
+    if (value.empty())
+    {
+        error(token, "valeur numérique attendue pour '" + token.key + "'");
+    }
 
-    return result;
+    long result = 0;
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        if (!std::isdigit(static_cast<unsigned char>(value[i])))
+        {
+            error(token, "valeur numérique attendue pour '" + token.key + "' : " + value);
+        }
+        result = result * 10 + (value[i] - '0');
+        if (result > INT_MAX)
+        {
+            error(token, "valeur trop grande pour '" + token.key + "' : " + value);
+        }
+    }
+    return static_cast<int>(result);
 }
 
-int ConfigParser::convertSizeToBytes(const std::string& sizeStr) const
+// Taille en octets avec suffixe facultatif k, m ou g ; une valeur vide vaut 0 (pas de limite)
+int ConfigParser::parseSize(const Token& token) const
 {
-    if (sizeStr.empty())
+    const std::string& value = token.value;
+    if (value.empty())
     {
-        LOG_INFO("La chaîne de taille est vide, renvoie 0.");
         return 0;
     }
 
-    std::string numPart;
     size_t idx = 0;
-    while (idx < sizeStr.size() && isdigit(sizeStr[idx]))
+    long size = 0;
+    while (idx < value.size() && std::isdigit(static_cast<unsigned char>(value[idx])))
     {
-        numPart += sizeStr[idx];
+        size = size * 10 + (value[idx] - '0');
+        if (size > INT_MAX)
+        {
+            size = INT_MAX;
+        }
         ++idx;
     }
-
-    if (numPart.empty())
+    if (idx == 0 || idx + 1 < value.size())
     {
-        LOG_WARNING("Aucune partie numérique trouvée, renvoie 0.");
-        return 0;
+        error(token, "taille invalide pour '" + token.key + "' : " + value);
     }
 
-    int size = atoi(numPart.c_str());
-    long finalSize;
-    if (idx < sizeStr.size())
+    long multiplier = 1;
+    if (idx < value.size())
     {
-        char lastChar = tolower(sizeStr[idx]);
-
-        switch (lastChar)
+        switch (std::tolower(static_cast<unsigned char>(value[idx])))
         {
             case 'k':
-                finalSize = static_cast<long>(size) * 1024;
+                multiplier = 1024;
                 break;
             case 'm':
-                finalSize = static_cast<long>(size) * 1024 * 1024;
+                multiplier = 1024 * 1024;
                 break;
             case 'g':
-                finalSize = static_cast<long>(size) * 1024 * 1024 * 1024;
+                multiplier = 1024 * 1024 * 1024;
                 break;
             default:
-                finalSize = size;
-                break;
+                error(token, "suffixe de taille inconnu pour '" + token.key + "' : " + value);
         }
     }
-    else
+
+    if (size > INT_MAX / multiplier)
     {
-        finalSize = size;
-        LOG_INFO("convertSizeToBytes -> Aucun multiplicateur trouvé, utilise la taille telle quelle.");
+        LOG_WARNING(locate(token) + ": taille supérieure à INT_MAX, ramenée à INT_MAX.");
+        return INT_MAX;
     }
+    return static_cast<int>(size * multiplier);
+}
 
-    if (finalSize > INT_MAX)
+bool ConfigParser::parseSwitch(const Token& token) const
+{
+    if (token.value == "on")
     {
-        LOG_WARNING("convertSizeToBytes -> La taille convertie dépasse INT_MAX, renvoie INT_MAX.");
-        return INT_MAX;
+        return true;
     }
-    else
+    if (token.value != "off")
     {
-        return static_cast<int>(finalSize);
+        error(token, "'on' ou 'off' attendu pour '" + token.key + "' : " + token.value);
     }
+    return false;
+}
+
+/**************************************************************************
+ *                              ERREURS                                   *
+ * ***********************************************************************/
+
+std::string ConfigParser::locate(const Token& token) const
+{
+    std::ostringstream oss;
+    oss << sourceFiles[token.fileIndex] << ":" << token.line << ":" << token.column;
+    return oss.str();
+}
+
+void ConfigParser::error(const Token& token, const std::string& message) const
+{
+    throw std::runtime_error(locate(token) + ": " + message);
 }
@@ -0,0 +1,114 @@
+#include "../includes/Histogram.hpp"
+
+Histogram::Histogram() : count(0), sumMicros(0)
+{
+    memset(counts, 0, sizeof(counts));
+}
+
+Histogram::~Histogram()
+{
+}
+
+/**************************************************************************
+ *                          METHODES PUBLIQUES                            *
+ * ***********************************************************************/
+
+void Histogram::record(unsigned long micros)
+{
+    ++counts[indexOf(micros)];
+    ++count;
+    sumMicros += micros;
+}
+
+unsigned long Histogram::getCount() const
+{
+    return count;
+}
+
+// Borne supérieure de l'intervalle qui contient le percentile demandé (0 à 100)
+unsigned long Histogram::valueAtPercentile(double percentile) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    unsigned long target = static_cast<unsigned long>(percentile / 100.0 * count + 0.5);
+    if (target == 0)
+    {
+        target = 1;
+    }
+
+    unsigned long seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += counts[i];
+        if (seen >= target)
+        {
+            return upperBound(i);
+        }
+    }
+    return upperBound(BUCKET_COUNT - 1);
+}
+
+// Format Prometheus : seaux cumulés en secondes (jusqu'à ~2 min, puis +Inf), somme et nombre.
+// Le nom et l'aide sont ajoutés tels quels, seules les valeurs passent par un tampon borné
+void Histogram::render(std::string& output, const char* name, const char* help) const
+{
+    char line[96];
+
+    output.append("# HELP ").append(name).append(" ").append(help);
+    output.append("\n# TYPE ").append(name).append(" histogram\n");
+
+    unsigned long cumulative = 0;
+    for (int i = 0; i < RENDERED_BUCKETS; ++i)
+    {
+        cumulative += counts[i];
+        if (i < SUB_BUCKETS - 1)
+        {
+            continue;
+        }
+        std::snprintf(line, sizeof(line), "_bucket{le=\"%.6g\"} %lu\n", upperBound(i) / 1e6, cumulative);
+        output.append(name).append(line);
+    }
+    std::snprintf(line, sizeof(line), "_bucket{le=\"+Inf\"} %lu\n", count);
+    output.append(name).append(line);
+    std::snprintf(line, sizeof(line), "_sum %.6f\n", sumMicros / 1e6);
+    output.append(name).append(line);
+    std::snprintf(line, sizeof(line), "_count %lu\n", count);
+    output.append(name).append(line);
+}
+
+/**************************************************************************
+ *                          METHODES PRIVEES                              *
+ * ***********************************************************************/
+
+// Les valeurs sous SUB_BUCKETS ont un intervalle chacune ; au-delà, l'exposant choisit l'octave et
+// les SUB_BUCKET_BITS bits suivant le bit de poids fort choisissent le sous-intervalle
+int Histogram::indexOf(unsigned long micros)
+{
+    if (micros >= (1UL << 32))
+    {
+        return BUCKET_COUNT - 1;
+    }
+    if (micros < static_cast<unsigned long>(SUB_BUCKETS))
+    {
+        return static_cast<int>(micros);
+    }
+
+    int exponent = 63 - __builtin_clzl(micros);
+    int subBucket = static_cast<int>((micros >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return SUB_BUCKETS + (exponent - SUB_BUCKET_BITS) * SUB_BUCKETS + subBucket;
+}
+
+unsigned long Histogram::upperBound(int index)
+{
+    if (index < SUB_BUCKETS)
+    {
+        return index;
+    }
+
+    int exponent = (index - SUB_BUCKETS) / SUB_BUCKETS + SUB_BUCKET_BITS;
+    unsigned long subBucket = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    return ((SUB_BUCKETS + subBucket + 1) << (exponent - SUB_BUCKET_BITS)) - 1;
+}
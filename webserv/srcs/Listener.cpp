@@ -0,0 +1,302 @@
+#include "../includes/Listener.hpp"
+
+Listener::Listener() : addressLength(0), fd(-1), noDelay(false), acceptBatch(1)
+{
+    memset(&address, 0, sizeof(address));
+}
+
+/**************************************************************************
+ *                          METHODES PUBLIQUES                            *
+ * ***********************************************************************/
+
+// "unix:/chemin" désigne un socket Unix ; "*" ou un host vide écoute sur toutes les interfaces IPv4, "::" sur IPv4 et IPv6
+bool Listener::resolve(const std::string& host, int port)
+{
+    memset(&address, 0, sizeof(address));
+    unixPath.clear();
+
+    if (host.compare(0, 5, "unix:") == 0)
+    {
+        struct sockaddr_un* unixAddress = reinterpret_cast<struct sockaddr_un*>(&address);
+        unixPath = host.substr(5);
+        if (unixPath.empty() || unixPath.size() >= sizeof(unixAddress->sun_path))
+        {
+            LOG_ERROR("Chemin de socket Unix invalide : " + host);
+            return false;
+        }
+        unixAddress->sun_family = AF_UNIX;
+        memcpy(unixAddress->sun_path, unixPath.c_str(), unixPath.size() + 1);
+        addressLength = sizeof(struct sockaddr_un);
+        key = host;
+        return true;
+    }
+
+    std::string node = host;
+    if (node.empty() || node == "*")
+    {
+        node = "0.0.0.0";
+    }
+    else if (node.size() > 2 && node[0] == '[' && node[node.size() - 1] == ']')
+    {
+        node = node.substr(1, node.size() - 2);
+    }
+
+    std::ostringstream service;
+    service << port;
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+
+    struct addrinfo* results = NULL;
+    int status = getaddrinfo(node.c_str(), service.str().c_str(), &hints, &results);
+    if (status != 0)
+    {
+        LOG_ERROR("Impossible de résoudre l'adresse d'écoute " + host + " : " + gai_strerror(status));
+        return false;
+    }
+
+    // Un nom qui se résout en IPv4 et en IPv6 est écouté en IPv4, comme avant
+    struct addrinfo* chosen = results;
+    for (struct addrinfo* it = results; it != NULL; it = it->ai_next)
+    {
+        if (it->ai_family == AF_INET)
+        {
+            chosen = it;
+            break;
+        }
+    }
+    memcpy(&address, chosen->ai_addr, chosen->ai_addrlen);
+    addressLength = chosen->ai_addrlen;
+    freeaddrinfo(results);
+
+    key = formatAddress(reinterpret_cast<struct sockaddr*>(&address), addressLength);
+    return true;
+}
+
+// Reprend un socket d'écoute hérité d'une autre instance lors d'une mise à jour du binaire
+bool Listener::adopt(int inheritedFd)
+{
+    memset(&address, 0, sizeof(address));
+    addressLength = sizeof(address);
+    if (getsockname(inheritedFd, reinterpret_cast<struct sockaddr*>(&address), &addressLength) != 0)
+    {
+        return false;
+    }
+
+    fd = inheritedFd;
+    key = formatAddress(reinterpret_cast<struct sockaddr*>(&address), addressLength);
+    unixPath.clear();
+    if (address.ss_family == AF_UNIX)
+    {
+        unixPath = reinterpret_cast<struct sockaddr_un*>(&address)->sun_path;
+    }
+    return true;
+}
+
+// Le socket d'écoute est non bloquant pour pouvoir vider la file d'attente jusqu'à EAGAIN
+bool Listener::open(const ServerConfig& serverConfig)
+{
+    int family = address.ss_family;
+
+    fd = socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+    {
+        LOG_ERROR("Échec de la création du socket pour " + key);
+        return false;
+    }
+
+    int opt = 1;
+    if (family != AF_UNIX && setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0)
+    {
+        LOG_ERROR("Échec de la configuration de SO_REUSEADDR pour " + key);
+        close();
+        return false;
+    }
+
+    // Double pile : un socket IPv6 accepte aussi les clients IPv4 (adresses ::ffff:a.b.c.d)
+    int v6only = 0;
+    if (family == AF_INET6 && setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only)) < 0)
+    {
+        LOG_WARNING("Impossible de désactiver IPV6_V6ONLY pour " + key);
+    }
+
+    // Un fichier de socket laissé par une instance précédente empêcherait le bind
+    if (family == AF_UNIX)
+    {
+        unlink(unixPath.c_str());
+    }
+
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&address), addressLength) < 0)
+    {
+        LOG_ERROR("Échec du bind sur " + key + " : " + strerror(errno));
+        close();
+        return false;
+    }
+
+    if (!configure(serverConfig))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+// Options d'un socket déjà lié ; rappelée lors d'un rechargement quand l'adresse est conservée.
+// Ne ferme pas le socket en cas d'échec : lors d'un rechargement, il sert encore à la configuration en place
+bool Listener::configure(const ServerConfig& serverConfig)
+{
+    int family = address.ss_family;
+
+    if (family != AF_UNIX)
+    {
+        applyTcpOptions(serverConfig);
+    }
+    noDelay = serverConfig.tcp_nodelay && family != AF_UNIX;
+    acceptBatch = serverConfig.accept_batch > 0 ? serverConfig.accept_batch : 1;
+
+    int backlog = serverConfig.listen_backlog > 0 ? serverConfig.listen_backlog : SOMAXCONN;
+    if (listen(fd, backlog) < 0)
+    {
+        LOG_ERROR("Échec de l'écoute sur " + key);
+        return false;
+    }
+
+    std::ostringstream oss;
+    oss << "Écoute sur " << key << " (backlog " << backlog << ", " << acceptBatch << " acceptations par réveil)";
+    LOG_INFO(oss.str());
+    return true;
+}
+
+void Listener::close()
+{
+    if (fd != -1)
+    {
+        ::close(fd);
+        fd = -1;
+        if (!unixPath.empty())
+        {
+            unlink(unixPath.c_str());
+        }
+    }
+}
+
+bool Listener::getNoDelay() const
+{
+    return noDelay;
+}
+
+int Listener::getAcceptBatch() const
+{
+    return acceptBatch;
+}
+
+// Ferme le descripteur sans supprimer le fichier d'un socket Unix, toujours utilisé par la nouvelle instance
+void Listener::detach()
+{
+    if (fd != -1)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+int Listener::getFd() const
+{
+    return fd;
+}
+
+int Listener::getFamily() const
+{
+    return address.ss_family;
+}
+
+const std::string& Listener::getKey() const
+{
+    return key;
+}
+
+// Adresse IP seule (les adresses IPv4 mappées en IPv6 sont rendues sous leur forme IPv4), ou "unix:/chemin" ;
+// un client Unix sans nom (socketpair, socket non lié) n'a que sa famille de renseignée et devient "unix:"
+std::string Listener::formatHost(const struct sockaddr* address, socklen_t length)
+{
+    char host[INET6_ADDRSTRLEN];
+
+    if (address->sa_family == AF_INET)
+    {
+        const struct sockaddr_in* in = reinterpret_cast<const struct sockaddr_in*>(address);
+        inet_ntop(AF_INET, &in->sin_addr, host, sizeof(host));
+        return host;
+    }
+    if (address->sa_family == AF_INET6)
+    {
+        const struct sockaddr_in6* in6 = reinterpret_cast<const struct sockaddr_in6*>(address);
+        if (IN6_IS_ADDR_V4MAPPED(&in6->sin6_addr))
+        {
+            inet_ntop(AF_INET, &in6->sin6_addr.s6_addr[12], host, sizeof(host));
+        }
+        else
+        {
+            inet_ntop(AF_INET6, &in6->sin6_addr, host, sizeof(host));
+        }
+        return host;
+    }
+    if (address->sa_family == AF_UNIX)
+    {
+        if (length <= offsetof(struct sockaddr_un, sun_path))
+        {
+            return "unix:";
+        }
+        const char* path = reinterpret_cast<const struct sockaddr_un*>(address)->sun_path;
+        size_t pathLength = length - offsetof(struct sockaddr_un, sun_path);
+        return std::string("unix:") + std::string(path, strnlen(path, pathLength));
+    }
+    return "";
+}
+
+// Forme canonique d'une adresse d'écoute : "a.b.c.d:port", "[v6]:port" ou "unix:/chemin"
+std::string Listener::formatAddress(const struct sockaddr* address, socklen_t length)
+{
+    std::ostringstream oss;
+
+    if (address->sa_family == AF_INET)
+    {
+        oss << formatHost(address, length) << ":" << ntohs(reinterpret_cast<const struct sockaddr_in*>(address)->sin_port);
+    }
+    else if (address->sa_family == AF_INET6)
+    {
+        char host[INET6_ADDRSTRLEN];
+        const struct sockaddr_in6* in6 = reinterpret_cast<const struct sockaddr_in6*>(address);
+        inet_ntop(AF_INET6, &in6->sin6_addr, host, sizeof(host));
+        oss << "[" << host << "]:" << ntohs(in6->sin6_port);
+    }
+    else
+    {
+        oss << formatHost(address, length);
+    }
+    return oss.str();
+}
+
+/**************************************************************************
+ *                          METHODES PRIVEES                              *
+ * ***********************************************************************/
+
+// Options facultatives : un échec est signalé mais n'empêche pas l'écoute
+void Listener::applyTcpOptions(const ServerConfig& serverConfig)
+{
+    // Le noyau ne réveille accept() qu'à l'arrivée des premières données, pas au simple établissement
+    if (serverConfig.tcp_defer_accept > 0
+        && setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &serverConfig.tcp_defer_accept, sizeof(serverConfig.tcp_defer_accept)) < 0)
+    {
+        LOG_WARNING("Impossible d'activer TCP_DEFER_ACCEPT sur " + key);
+    }
+
+    // Longueur de la file des connexions TFO dont la requête arrive avec le SYN
+    if (serverConfig.tcp_fastopen > 0
+        && setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, &serverConfig.tcp_fastopen, sizeof(serverConfig.tcp_fastopen)) < 0)
+    {
+        LOG_WARNING("Impossible d'activer TCP_FASTOPEN sur " + key);
+    }
+}
@@ -0,0 +1,120 @@
+#include "../includes/LocationTree.hpp"
+
+LocationTree::LocationTree() : root(new Node(""))
+{
+}
+
+LocationTree::~LocationTree()
+{
+    destroy(root);
+}
+
+/**************************************************************************
+ *                          METHODES PUBLIQUES                            *
+ * ***********************************************************************/
+
+// Arbre radix compressé : chaque arête porte un fragment de chemin, découpé lorsqu'une nouvelle clé diverge en son milieu
+bool LocationTree::insert(const std::string& key, const ServerConfig* config, bool exact)
+{
+    Node* node = root;
+    size_t pos = 0;
+
+    while (pos < key.size())
+    {
+        std::map<char, Node*>::iterator it = node->children.find(key[pos]);
+        if (it == node->children.end())
+        {
+            Node* leaf = new Node(key.substr(pos));
+            node->children[key[pos]] = leaf;
+            node = leaf;
+            break;
+        }
+
+        Node* child = it->second;
+        size_t common = 0;
+        while (common < child->label.size() && pos + common < key.size() && child->label[common] == key[pos + common])
+        {
+            ++common;
+        }
+
+        if (common < child->label.size())
+        {
+            Node* middle = new Node(child->label.substr(0, common));
+            child->label.erase(0, common);
+            middle->children[child->label[0]] = child;
+            it->second = middle;
+            child = middle;
+        }
+
+        node = child;
+        pos += common;
+    }
+
+    const ServerConfig*& slot = exact ? node->exactConfig : node->prefixConfig;
+    if (slot)
+    {
+        return false;
+    }
+    slot = config;
+    return true;
+}
+
+const ServerConfig* LocationTree::findExact(const std::string& path) const
+{
+    const ServerConfig* longestPrefix = NULL;
+    const Node* node = walk(path, &longestPrefix);
+
+    return node ? node->exactConfig : NULL;
+}
+
+const ServerConfig* LocationTree::findLongestPrefix(const std::string& path) const
+{
+    const ServerConfig* longestPrefix = NULL;
+    walk(path, &longestPrefix);
+
+    return longestPrefix;
+}
+
+/**************************************************************************
+ *                          METHODES PRIVEES                              *
+ * ***********************************************************************/
+
+// Descend le long du chemin en retenant le dernier préfixe rencontré ; renvoie le nœud atteint si le chemin est consommé en entier
+const LocationTree::Node* LocationTree::walk(const std::string& path, const ServerConfig** longestPrefix) const
+{
+    const Node* node = root;
+    size_t pos = 0;
+
+    *longestPrefix = root->prefixConfig;
+    while (pos < path.size())
+    {
+        std::map<char, Node*>::const_iterator it = node->children.find(path[pos]);
+        if (it == node->children.end())
+        {
+            return NULL;
+        }
+
+        const Node* child = it->second;
+        if (path.compare(pos, child->label.size(), child->label) != 0)
+        {
+            return NULL;
+        }
+
+        pos += child->label.size();
+        node = child;
+        if (node->prefixConfig)
+        {
+            *longestPrefix = node->prefixConfig;
+        }
+    }
+    return node;
+}
+
+void LocationTree::destroy(Node* node)
+{
+    for (std::map<char, Node*>::iterator it = node->children.begin(); it != node->children.end(); ++it)
+    {
+        destroy(it->second);
+    }
+    delete node;
+}
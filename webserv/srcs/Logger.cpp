@@ -1,3 +1,4 @@
+
 #include "../includes/Logger.hpp"
 
 const char* Logger::RESET = "\033[0m";
@@ -7,26 +8,38 @@ const char* Logger::GREEN = "\033[32m";
 
 Logger& Logger::getInstance()
 {
-    static Logger instance("server.log", INFO, WARNING);
+    // Aucun fichier ni thread d'écriture avant le premier configure() : "webserv -t" n'écrit que sur la console
+    static Logger instance("", INFO, WARNING);
 
     return instance;
 }
 
 Logger::Logger(const std::string& filename, Level fileLogLevel, Level consoleLogLevel) 
-: fileLogLevel(fileLogLevel), consoleLogLevel(consoleLogLevel)
+: fileFd(-1), consoleFd(STDOUT_FILENO), fileLogLevel(fileLogLevel), consoleLogLevel(consoleLogLevel), ring(new Slot[LOG_RING_SIZE]), enqueuePos(0),
+  dequeuePos(0), dropped(0), blockOnOverflow(false), writerRunning(false), stopRequested(false), writerSleeping(0), cleanedUp(false), cachedSecond(-1)
 {
     pthread_mutex_init(&mutex, NULL);
-    fileStream.open(filename.c_str(), std::ios::app);
+    pthread_mutex_init(&wakeupMutex, NULL);
+    pthread_cond_init(&wakeup, NULL);
+
+    for (size_t i = 0; i < LOG_RING_SIZE; ++i)
+    {
+        ring[i].sequence = i;
+    }
 
-    if (!fileStream.is_open())
+    pthread_atfork(NULL, NULL, afterFork);
+    if (!filename.empty())
     {
-        std::cerr << "Erreur lors de l'ouverture du fichier de log : " << filename << std::endl;
+        configure(filename, fileLogLevel, consoleLogLevel);
     }
 }
 
 Logger::~Logger()
 {
+    // Les primitives de synchronisation ne sont pas détruites : dans un fils CGI qui quitte après un execve
+    // raté, pthread_cond_destroy attendrait indéfiniment le thread d'écriture du parent
     cleanup();
+    delete[] ring;
 }
 
 void Logger::configure(const std::string& filename, Level fileLogLevel, Level consoleLogLevel)
@@ -35,26 +48,271 @@ void Logger::configure(const std::string& filename, Level fileLogLevel, Level co
     this->fileLogLevel = fileLogLevel;
     this->consoleLogLevel = consoleLogLevel;
 
-    if (fileStream.is_open())
+    if (fileFd >= 0)
     {
-        fileStream.close();
+        close(fileFd);
     }
 
-    fileStream.open(filename.c_str(), std::ios::app);
+    fileFd = open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
 
-    if (!fileStream)
+    if (fileFd < 0)
     {
         std::cerr << "Erreur lors de l'ouverture du fichier de log: " << filename << std::endl;
     }
 
     pthread_mutex_unlock(&mutex);
+
+    // Sans thread d'écriture (échec de création, processus fils), les messages sont écrits directement
+    if (!writerRunning && !cleanedUp)
+    {
+        writerRunning = (pthread_create(&writer, NULL, writerMain, this) == 0);
+    }
+}
+
+// Sortie console des messages, la sortie standard par défaut
+void Logger::setConsoleFd(int fd)
+{
+    pthread_mutex_lock(&mutex);
+    consoleFd = fd;
+    pthread_mutex_unlock(&mutex);
+}
+
+// Anneau plein : le message est perdu (et compté) ou le producteur attend qu'une case se libère
+void Logger::setBlockOnOverflow(bool block)
+{
+    blockOnOverflow = block;
 }
 
 void Logger::log(const std::string& message, Level level, const char* file, int line, const char* function)
 {
+    if (level < fileLogLevel && level < consoleLogLevel)
+    {
+        return;
+    }
+
+    if (writerRunning)
+    {
+        enqueue(message, level, file, line, function);
+        return;
+    }
+
+    std::string logMessage;
+    format(logMessage, level, std::time(0), file, line, function, message);
+
     pthread_mutex_lock(&mutex);
+    if (fileFd >= 0 && level >= fileLogLevel)
+    {
+        writeAll(fileFd, logMessage);
+    }
+    if (level >= consoleLogLevel)
+    {
+        writeAll(consoleFd, logMessage);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+// Arrête le thread d'écriture après qu'il a vidé l'anneau ; les messages suivants sont écrits directement
+void Logger::cleanup()
+{
+    if (cleanedUp)
+    {
+        return;
+    }
+    cleanedUp = true;
+
+    if (writerRunning)
+    {
+        stopRequested = true;
+        pthread_mutex_lock(&wakeupMutex);
+        pthread_cond_signal(&wakeup);
+        pthread_mutex_unlock(&wakeupMutex);
+        pthread_join(writer, NULL);
+        writerRunning = false;
+    }
+
+    pthread_mutex_lock(&mutex);
+    if (fileFd >= 0)
+    {
+        close(fileFd);
+        fileFd = -1;
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+/**************************************************************************
+ *                          ANNEAU ET ECRITURE                            *
+ * ***********************************************************************/
+
+// File bornée de Vyukov : un producteur réserve une case par CAS sur enqueuePos, la remplit puis la publie via sequence
+void Logger::enqueue(const std::string& message, Level level, const char* file, int line, const char* function)
+{
+    size_t pos = enqueuePos;
+    Slot* slot;
+
+    while (true)
+    {
+        slot = &ring[pos & (LOG_RING_SIZE - 1)];
+        long diff = static_cast<long>(slot->sequence) - static_cast<long>(pos);
+
+        if (diff == 0)
+        {
+            if (__sync_bool_compare_and_swap(&enqueuePos, pos, pos + 1))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            if (!blockOnOverflow)
+            {
+                __sync_fetch_and_add(&dropped, 1);
+                return;
+            }
+            wakeWriter();
+            sched_yield();
+        }
+        pos = enqueuePos;
+    }
+
+    slot->level = level;
+    slot->time = Clock::getInstance().now();
+    slot->file = file;
+    slot->line = line;
+    slot->function = function;
+    slot->message.assign(message);
+    __sync_synchronize();
+    slot->sequence = pos + 1;
+    __sync_synchronize();
+
+    // Le thread d'écriture se réveille seul toutes les LOG_FLUSH_INTERVAL_MS ; on ne le presse qu'en cas d'erreur ou d'anneau à moitié plein
+    if (level == ERROR || pos + 1 - dequeuePos >= LOG_RING_SIZE / 2)
+    {
+        wakeWriter();
+    }
+}
+
+void Logger::wakeWriter()
+{
+    if (writerSleeping)
+    {
+        pthread_mutex_lock(&wakeupMutex);
+        pthread_cond_signal(&wakeup);
+        pthread_mutex_unlock(&wakeupMutex);
+    }
+}
+
+void* Logger::writerMain(void* logger)
+{
+    static_cast<Logger*>(logger)->writerLoop();
+    return NULL;
+}
+
+void Logger::writerLoop()
+{
+    std::string fileBatch;
+    std::string consoleBatch;
+
+    while (true)
+    {
+        bool stopping = stopRequested;
+        __sync_synchronize();
 
-    std::ostringstream logMessage;
+        if (drain(fileBatch, consoleBatch) > 0)
+        {
+            writeBatches(fileBatch, consoleBatch);
+            continue;
+        }
+        if (stopping)
+        {
+            break;
+        }
+
+        pthread_mutex_lock(&wakeupMutex);
+        writerSleeping = 1;
+        __sync_synchronize();
+        if (ring[dequeuePos & (LOG_RING_SIZE - 1)].sequence != dequeuePos + 1 && !stopRequested)
+        {
+            struct timeval now;
+            gettimeofday(&now, NULL);
+            long nsec = now.tv_usec * 1000L + LOG_FLUSH_INTERVAL_MS * 1000000L;
+            struct timespec deadline;
+            deadline.tv_sec = now.tv_sec + nsec / 1000000000L;
+            deadline.tv_nsec = nsec % 1000000000L;
+            pthread_cond_timedwait(&wakeup, &wakeupMutex, &deadline);
+        }
+        writerSleeping = 0;
+        pthread_mutex_unlock(&wakeupMutex);
+    }
+}
+
+// Formate tous les messages publiés ; la chaîne de chaque case garde sa capacité pour le prochain producteur
+size_t Logger::drain(std::string& fileBatch, std::string& consoleBatch)
+{
+    std::string logMessage;
+    size_t count = 0;
+
+    while (true)
+    {
+        Slot& slot = ring[dequeuePos & (LOG_RING_SIZE - 1)];
+        if (slot.sequence != dequeuePos + 1)
+        {
+            break;
+        }
+        __sync_synchronize();
+
+        logMessage.clear();
+        format(logMessage, slot.level, slot.time, slot.file, slot.line, slot.function, slot.message);
+        if (slot.level >= fileLogLevel)
+        {
+            fileBatch += logMessage;
+        }
+        if (slot.level >= consoleLogLevel)
+        {
+            consoleBatch += logMessage;
+        }
+
+        __sync_synchronize();
+        slot.sequence = dequeuePos + LOG_RING_SIZE;
+        ++dequeuePos;
+        ++count;
+    }
+
+    size_t lost = dropped;
+    if (lost > 0)
+    {
+        __sync_fetch_and_sub(&dropped, lost);
+        std::ostringstream oss;
+        oss << lost << " message(s) de journal perdu(s), anneau plein.";
+        logMessage.clear();
+        format(logMessage, WARNING, std::time(0), NULL, 0, NULL, oss.str());
+        fileBatch += logMessage;
+        consoleBatch += logMessage;
+        ++count;
+    }
+    return count;
+}
+
+void Logger::writeBatches(std::string& fileBatch, std::string& consoleBatch)
+{
+    if (!fileBatch.empty())
+    {
+        pthread_mutex_lock(&mutex);
+        if (fileFd >= 0)
+        {
+            writeAll(fileFd, fileBatch);
+        }
+        pthread_mutex_unlock(&mutex);
+        fileBatch.clear();
+    }
+    if (!consoleBatch.empty())
+    {
+        writeAll(consoleFd, consoleBatch);
+        consoleBatch.clear();
+    }
+}
+
+void Logger::format(std::string& output, Level level, std::time_t time, const char* file, int line, const char* function, const std::string& message)
+{
     const char* color = RESET;
 
     switch (level)
@@ -67,42 +325,57 @@ void Logger::log(const std::string& message, Level level, const char* file, int
         break;
     }
 
-    logMessage << color << "[" << currentTime() << "][" << levelToString(level) << "]";
+    output += color;
+    output += "[" + currentTime(time) + "][" + levelToString(level) + "]";
 
     if (file)
     {
-        logMessage << "[" << file << ":" << line << "]";
+        char lineNumber[16];
+        std::sprintf(lineNumber, "%d", line);
+        output += "[";
+        output += file;
+        output += ":";
+        output += lineNumber;
+        output += "]";
     }
 
     if (function)
     {
-        logMessage << "[" << function << "]";
-    }
-
-    logMessage << " " << message << RESET;
-
-    if (fileStream.is_open() && level >= fileLogLevel)
-    {
-        fileStream << logMessage.str() << std::endl;
-        fileStream.flush();
+        output += "[";
+        output += function;
+        output += "]";
     }
 
-    if (level >= consoleLogLevel)
-    {
-        std::cout << logMessage.str() << std::endl;
-    }
-
-    pthread_mutex_unlock(&mutex);
+    output += " ";
+    output += message;
+    output += RESET;
+    output += "\n";
 }
 
+// Dans le fils, le thread d'écriture n'existe plus et le mutex a pu être copié verrouillé
+void Logger::afterFork()
+{
+    Logger& logger = getInstance();
+    logger.writerRunning = false;
+    pthread_mutex_init(&logger.mutex, NULL);
+}
 
-void Logger::cleanup()
+void Logger::writeAll(int fd, const std::string& data)
 {
-    if (fileStream.is_open())
+    size_t written = 0;
+    while (written < data.size())
     {
-        fileStream.close();
+        ssize_t result = write(fd, data.data() + written, data.size() - written);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            return;
+        }
+        written += result;
     }
-    pthread_mutex_destroy(&mutex);
 }
 
 std::string Logger::levelToString(Level level)
@@ -120,12 +393,17 @@ std::string Logger::levelToString(Level level)
     }
 }
 
-std::string Logger::currentTime()
+// Appelée par le thread d'écriture (ou en écriture directe quand il ne tourne pas) : une conversion par seconde au plus
+std::string Logger::currentTime(std::time_t now)
 {
-    std::time_t now = std::time(0);
-    char buffer[20];
-    std::strftime(buffer, 20, "%Y-%m-%d %H:%M:%S", std::localtime(&now));
-
-    return std::string(buffer);
+    if (now != cachedSecond)
+    {
+        struct tm local;
+        char buffer[20];
+        localtime_r(&now, &local);
+        std::strftime(buffer, 20, "%Y-%m-%d %H:%M:%S", &local);
+        cachedSecond = now;
+        cachedTime = buffer;
+    }
+    return cachedTime;
 }
-
@@ -0,0 +1,127 @@
+#include "../includes/Metrics.hpp"
+
+// Noms et descriptions exportés, dans l'ordre des énumérations
+static const char* COUNTER_NAMES[][2] = {
+    { "webserv_connections_accepted_total", "Connexions acceptées." },
+    { "webserv_connections_closed_total", "Connexions fermées." },
+    { "webserv_connections_rejected_total", "Connexions refusées dès accept() (allowed_ips, max_connections_per_ip)." },
+    { "webserv_requests_rate_limited_total", "Requêtes refusées par rate_limit (429)." },
+    { "webserv_requests_denied_total", "Requêtes refusées par les règles d'accès du serveur virtuel (403)." },
+    { "webserv_response_bytes_total", "Octets de réponse mis en file d'envoi." },
+    { "webserv_cgi_executions_total", "Scripts CGI exécutés." },
+    { "webserv_cgi_cache_hits_total", "Réponses CGI servies depuis le cache." },
+    { "webserv_cgi_cache_misses_total", "Réponses CGI absentes du cache." },
+    { "webserv_event_loop_iterations_total", "Réveils de la boucle select()." },
+    { "webserv_slow_requests_total", "Requêtes au-delà de slow_log_threshold." }
+};
+
+static const char* GAUGE_NAMES[][2] = {
+    { "webserv_connections_active", "Connexions clientes ouvertes." },
+    { "webserv_listeners", "Sockets d'écoute ouverts." },
+    { "webserv_rate_limiter_entries", "Adresses suivies par le limiteur." }
+};
+
+static const char* TIMING_NAMES[][2] = {
+    { "webserv_request_duration_seconds", "Du premier octet de la requête à la mise en file de la réponse." },
+    { "webserv_handler_duration_seconds", "Durée de RequestHandler::handleRequest." },
+    { "webserv_cgi_duration_seconds", "Durée de CgiHandler::executeScript." },
+    { "webserv_static_file_duration_seconds", "Lecture d'un fichier statique." },
+    { "webserv_event_loop_duration_seconds", "Traitement d'un réveil de la boucle select()." }
+};
+
+Metrics& Metrics::getInstance()
+{
+    static Metrics instance;
+
+    return instance;
+}
+
+Metrics::Metrics()
+{
+    memset(counters, 0, sizeof(counters));
+    memset(gauges, 0, sizeof(gauges));
+    memset(responses, 0, sizeof(responses));
+}
+
+Metrics::~Metrics()
+{
+}
+
+/**************************************************************************
+ *                          METHODES PUBLIQUES                            *
+ * ***********************************************************************/
+
+// Les réponses sont comptées par classe de statut : 1xx à 5xx, l'indice 0 regroupe les codes hors norme
+void Metrics::countResponse(int statusCode)
+{
+    int statusClass = statusCode / 100;
+    ++responses[(statusClass >= 1 && statusClass <= 5) ? statusClass : 0];
+}
+
+const Histogram& Metrics::getHistogram(Timing timing) const
+{
+    return histograms[timing];
+}
+
+unsigned long Metrics::getCounter(Counter counter) const
+{
+    return counters[counter];
+}
+
+unsigned long Metrics::getResponseCount() const
+{
+    unsigned long total = 0;
+    for (int i = 0; i < 6; ++i)
+    {
+        total += responses[i];
+    }
+    return total;
+}
+
+// Format texte d'exposition de Prometheus (version 0.0.4)
+std::string Metrics::render() const
+{
+    std::string output;
+    char line[96];
+
+    // Noms et aides ajoutés tels quels : seules les valeurs passent par le tampon
+    output.reserve(16384);
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+    {
+        output.append("# HELP ").append(COUNTER_NAMES[i][0]).append(" ").append(COUNTER_NAMES[i][1]);
+        output.append("\n# TYPE ").append(COUNTER_NAMES[i][0]).append(" counter\n").append(COUNTER_NAMES[i][0]);
+        std::snprintf(line, sizeof(line), " %lu\n", counters[i]);
+        output += line;
+    }
+
+    output += "# HELP webserv_requests_total Réponses envoyées par classe de statut.\n# TYPE webserv_requests_total counter\n";
+    for (int i = 1; i <= 5; ++i)
+    {
+        std::snprintf(line, sizeof(line), "webserv_requests_total{code=\"%dxx\"} %lu\n", i, responses[i]);
+        output += line;
+    }
+    std::snprintf(line, sizeof(line), "webserv_requests_total{code=\"other\"} %lu\n", responses[0]);
+    output += line;
+
+    for (int i = 0; i < GAUGE_COUNT; ++i)
+    {
+        output.append("# HELP ").append(GAUGE_NAMES[i][0]).append(" ").append(GAUGE_NAMES[i][1]);
+        output.append("\n# TYPE ").append(GAUGE_NAMES[i][0]).append(" gauge\n").append(GAUGE_NAMES[i][0]);
+        std::snprintf(line, sizeof(line), " %lu\n", gauges[i]);
+        output += line;
+    }
+
+    for (int i = 0; i < TIMING_COUNT; ++i)
+    {
+        histograms[i].render(output, TIMING_NAMES[i][0], TIMING_NAMES[i][1]);
+    }
+    return output;
+}
+
+unsigned long Metrics::elapsedMicros(const struct timeval& start)
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    long micros = (now.tv_sec - start.tv_sec) * 1000000L + (now.tv_usec - start.tv_usec);
+    return micros > 0 ? static_cast<unsigned long>(micros) : 0;
+}
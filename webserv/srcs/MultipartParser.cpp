@@ -0,0 +1,352 @@
+#include "../includes/MultipartParser.hpp"
+
+// Taille maximale acceptée pour les en-têtes d'une partie
+static const size_t MAX_PART_HEADERS_SIZE = 8192;
+
+MultipartParser::MultipartParser(const std::string& boundary, const std::string& uploadDir)
+: state(PREAMBLE), delimiter("\r\n--" + boundary), uploadDir(uploadDir), pending("\r\n"), tempFd(-1)
+{
+    // Table de décalage de Boyer-Moore-Horspool pour le délimiteur
+    size_t length = delimiter.size();
+    for (size_t i = 0; i < 256; ++i)
+    {
+        skipTable[i] = length;
+    }
+    for (size_t i = 0; i + 1 < length; ++i)
+    {
+        skipTable[static_cast<unsigned char>(delimiter[i])] = length - 1 - i;
+    }
+}
+
+MultipartParser::~MultipartParser()
+{
+    abortPart();
+}
+
+/**************************************************************************
+ *                          METHODES PUBLIQUES                            *
+ * ***********************************************************************/
+
+bool MultipartParser::feed(const char* data, size_t length)
+{
+    if (state == FAILED)
+    {
+        return false;
+    }
+    if (state == DONE)
+    {
+        return true;
+    }
+
+    pending.append(data, length);
+    return process();
+}
+
+bool MultipartParser::isComplete() const
+{
+    return state == DONE;
+}
+
+bool MultipartParser::hasFailed() const
+{
+    return state == FAILED;
+}
+
+const std::vector<std::string>& MultipartParser::getFiles() const
+{
+    return files;
+}
+
+/**************************************************************************
+ *                          ANALYSE DU FLUX                               *
+ * ***********************************************************************/
+
+bool MultipartParser::process()
+{
+    while (true)
+    {
+        if (state == PREAMBLE)
+        {
+            size_t pos = findDelimiter();
+            if (pos == std::string::npos)
+            {
+                if (pending.size() >= delimiter.size())
+                {
+                    pending.erase(0, pending.size() - (delimiter.size() - 1));
+                }
+                return true;
+            }
+            pending.erase(0, pos + delimiter.size());
+            state = AFTER_DELIMITER;
+        }
+        else if (state == AFTER_DELIMITER)
+        {
+            if (pending.size() < 2)
+            {
+                return true;
+            }
+            if (pending.compare(0, 2, "--") == 0)
+            {
+                LOG_INFO("Fin du corps multipart atteinte.");
+                state = DONE;
+                pending.clear();
+                return true;
+            }
+            if (pending.compare(0, 2, "\r\n") != 0)
+            {
+                fail("Délimiteur multipart mal formé.");
+                return false;
+            }
+            pending.erase(0, 2);
+            state = PART_HEADERS;
+        }
+        else if (state == PART_HEADERS)
+        {
+            std::string headers;
+            if (pending.compare(0, 2, "\r\n") == 0)
+            {
+                pending.erase(0, 2);
+            }
+            else
+            {
+                std::string::size_type end = pending.find("\r\n\r\n");
+                if (end == std::string::npos)
+                {
+                    if (pending.size() > MAX_PART_HEADERS_SIZE)
+                    {
+                        fail("En-têtes de partie multipart trop volumineux.");
+                        return false;
+                    }
+                    return true;
+                }
+                headers = pending.substr(0, end);
+                pending.erase(0, end + 4);
+            }
+
+            if (!parsePartHeaders(headers))
+            {
+                return false;
+            }
+            state = PART_BODY;
+        }
+        else if (state == PART_BODY)
+        {
+            size_t pos = findDelimiter();
+            if (pos == std::string::npos)
+            {
+                // On conserve les derniers octets qui pourraient être le début du délimiteur
+                if (pending.size() >= delimiter.size())
+                {
+                    size_t safe = pending.size() - (delimiter.size() - 1);
+                    if (!writePartData(pending.data(), safe))
+                    {
+                        return false;
+                    }
+                    pending.erase(0, safe);
+                }
+                return true;
+            }
+            if (!writePartData(pending.data(), pos) || !finishPart())
+            {
+                return false;
+            }
+            pending.erase(0, pos + delimiter.size());
+            state = AFTER_DELIMITER;
+        }
+        else
+        {
+            return state != FAILED;
+        }
+    }
+}
+
+size_t MultipartParser::findDelimiter() const
+{
+    size_t length = delimiter.size();
+    size_t size = pending.size();
+    if (size < length)
+    {
+        return std::string::npos;
+    }
+
+    const char* haystack = pending.data();
+    size_t i = 0;
+    while (i <= size - length)
+    {
+        size_t j = length - 1;
+        while (haystack[i + j] == delimiter[j])
+        {
+            if (j == 0)
+            {
+                return i;
+            }
+            --j;
+        }
+        i += skipTable[static_cast<unsigned char>(haystack[i + length - 1])];
+    }
+    return std::string::npos;
+}
+
+bool MultipartParser::parsePartHeaders(const std::string& headers)
+{
+    fileName.clear();
+
+    std::string::size_type start = 0;
+    while (start < headers.size())
+    {
+        std::string::size_type end = headers.find("\r\n", start);
+        if (end == std::string::npos)
+        {
+            end = headers.size();
+        }
+        std::string line = headers.substr(start, end - start);
+        start = end + 2;
+
+        std::string lower = line;
+        for (size_t i = 0; i < lower.size(); ++i)
+        {
+            lower[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(lower[i])));
+        }
+        if (lower.compare(0, 20, "content-disposition:") != 0)
+        {
+            continue;
+        }
+
+        LOG_INFO("Content-Disposition trouvé : " + line);
+        std::string::size_type filenamePos = lower.find("filename=");
+        if (filenamePos == std::string::npos)
+        {
+            continue;
+        }
+        filenamePos += 9;
+
+        std::string name;
+        if (filenamePos < line.size() && line[filenamePos] == '"')
+        {
+            std::string::size_type filenameEnd = line.find('"', filenamePos + 1);
+            if (filenameEnd != std::string::npos)
+            {
+                name = line.substr(filenamePos + 1, filenameEnd - filenamePos - 1);
+            }
+        }
+        else
+        {
+            name = line.substr(filenamePos, line.find(';', filenamePos) - filenamePos);
+        }
+
+        fileName = sanitizeFileName(name);
+        if (fileName.empty())
+        {
+            LOG_WARNING("Nom de fichier rejeté dans la partie multipart : " + name);
+        }
+    }
+
+    if (!fileName.empty())
+    {
+        LOG_INFO("Nom du fichier extrait : " + fileName);
+        return openTempFile();
+    }
+    return true;
+}
+
+/**************************************************************************
+ *                          GESTION DES FICHIERS                          *
+ * ***********************************************************************/
+
+bool MultipartParser::openTempFile()
+{
+    std::string pattern = uploadDir + "/.upload-XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+
+    tempFd = mkstemp(&path[0]);
+    if (tempFd < 0)
+    {
+        fail("Impossible de créer le fichier temporaire dans " + uploadDir);
+        return false;
+    }
+    tempPath = &path[0];
+    fchmod(tempFd, 0644);
+    return true;
+}
+
+bool MultipartParser::writePartData(const char* data, size_t length)
+{
+    if (tempFd < 0)
+    {
+        return true;
+    }
+
+    size_t written = 0;
+    while (written < length)
+    {
+        ssize_t result = write(tempFd, data + written, length - written);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fail("Erreur lors de l'écriture du fichier temporaire : " + tempPath);
+            return false;
+        }
+        written += result;
+    }
+    return true;
+}
+
+bool MultipartParser::finishPart()
+{
+    if (tempFd < 0)
+    {
+        return true;
+    }
+
+    close(tempFd);
+    tempFd = -1;
+
+    std::string target = uploadDir + "/" + fileName;
+    if (std::rename(tempPath.c_str(), target.c_str()) != 0)
+    {
+        fail("Impossible de renommer le fichier temporaire vers " + target);
+        return false;
+    }
+
+    LOG_INFO("Fichier sauvegardé avec succès : " + target);
+    files.push_back(fileName);
+    tempPath.clear();
+    return true;
+}
+
+void MultipartParser::abortPart()
+{
+    if (tempFd >= 0)
+    {
+        close(tempFd);
+        tempFd = -1;
+    }
+    if (!tempPath.empty())
+    {
+        unlink(tempPath.c_str());
+        tempPath.clear();
+    }
+}
+
+void MultipartParser::fail(const std::string& reason)
+{
+    LOG_ERROR(reason);
+    abortPart();
+    state = FAILED;
+}
+
+std::string MultipartParser::sanitizeFileName(const std::string& name)
+{
+    std::string::size_type slash = name.find_last_of("/\\");
+    std::string base = (slash == std::string::npos) ? name : name.substr(slash + 1);
+
+    if (base == "." || base == "..")
+    {
+        return "";
+    }
+    return base;
+}
@@ -0,0 +1,235 @@
+#include "../includes/RateLimiter.hpp"
+
+RateLimiter::RateLimiter() : count(0), lastDecay(currentTimeMs())
+{
+}
+
+RateLimiter::~RateLimiter()
+{
+}
+
+/**************************************************************************
+ *                          METHODES PUBLIQUES                            *
+ * ***********************************************************************/
+
+// Compte une connexion ouverte par l'adresse ; refuse au-delà de maxConnections (0 : pas de limite).
+// Les clients des sockets Unix, sans adresse, ne sont jamais limités
+bool RateLimiter::acquireConnection(const std::string& address, int maxConnections)
+{
+    unsigned char key[16];
+    if (!AccessList::makeKey(address, key))
+    {
+        return true;
+    }
+
+    // Table pleine : on laisse passer plutôt que de refuser des clients légitimes
+    Entry* entry = find(key, true);
+    if (!entry)
+    {
+        return true;
+    }
+    if (maxConnections > 0 && entry->connections >= maxConnections)
+    {
+        return false;
+    }
+    ++entry->connections;
+    return true;
+}
+
+void RateLimiter::releaseConnection(const std::string& address)
+{
+    unsigned char key[16];
+    if (!AccessList::makeKey(address, key))
+    {
+        return;
+    }
+
+    Entry* entry = find(key, false);
+    if (entry && entry->connections > 0)
+    {
+        --entry->connections;
+    }
+}
+
+// Seau de jetons : rate jetons par seconde, au plus burst en réserve (rate si burst vaut 0)
+bool RateLimiter::consumeRequest(const std::string& address, int rate, int burst)
+{
+    if (rate <= 0)
+    {
+        return true;
+    }
+
+    unsigned char key[16];
+    if (!AccessList::makeKey(address, key))
+    {
+        return true;
+    }
+
+    Entry* entry = find(key, true);
+    if (!entry)
+    {
+        return true;
+    }
+
+    double capacity = burst > 0 ? burst : rate;
+    long now = currentTimeMs();
+    if (entry->tokens < 0)
+    {
+        entry->tokens = capacity;
+    }
+    else
+    {
+        entry->tokens += (now - entry->lastRefill) * rate / 1000.0;
+        if (entry->tokens > capacity)
+        {
+            entry->tokens = capacity;
+        }
+    }
+    entry->lastRefill = now;
+
+    if (entry->tokens < 1)
+    {
+        return false;
+    }
+    entry->tokens -= 1;
+    return true;
+}
+
+// Purge périodique : une adresse sans connexion ouverte et inactive depuis un intervalle est oubliée
+void RateLimiter::decay()
+{
+    long now = currentTimeMs();
+    if (now - lastDecay < RATE_LIMIT_DECAY_INTERVAL * 1000L)
+    {
+        return;
+    }
+    lastDecay = now;
+
+    size_t before = count;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        Entry& entry = entries[i];
+        if (entry.used && entry.connections == 0 && now - entry.lastRefill >= RATE_LIMIT_DECAY_INTERVAL * 1000L)
+        {
+            entry.used = false;
+            --count;
+        }
+    }
+    if (count == before)
+    {
+        return;
+    }
+
+    // Le sondage linéaire ne tolère pas les trous : la table est reconstruite, réduite si possible
+    size_t capacity = 64;
+    while (capacity < count * 2)
+    {
+        capacity *= 2;
+    }
+    rehash(capacity);
+}
+
+size_t RateLimiter::size() const
+{
+    return count;
+}
+
+/**************************************************************************
+ *                          METHODES PRIVEES                              *
+ * ***********************************************************************/
+
+// Adressage ouvert à sondage linéaire, capacité en puissance de deux et facteur de charge maximal de 1/2
+RateLimiter::Entry* RateLimiter::find(const unsigned char* key, bool create)
+{
+    if (entries.empty())
+    {
+        if (!create)
+        {
+            return NULL;
+        }
+        rehash(64);
+    }
+
+    size_t mask = entries.size() - 1;
+    size_t idx = hash(key) & mask;
+    while (entries[idx].used)
+    {
+        if (memcmp(entries[idx].address, key, 16) == 0)
+        {
+            return &entries[idx];
+        }
+        idx = (idx + 1) & mask;
+    }
+    if (!create)
+    {
+        return NULL;
+    }
+
+    if (count >= RATE_LIMIT_MAX_ENTRIES)
+    {
+        return NULL;
+    }
+    if ((count + 1) * 2 > entries.size())
+    {
+        rehash(entries.size() * 2);
+        mask = entries.size() - 1;
+        idx = hash(key) & mask;
+        while (entries[idx].used)
+        {
+            idx = (idx + 1) & mask;
+        }
+    }
+
+    Entry& entry = entries[idx];
+    memcpy(entry.address, key, 16);
+    entry.used = true;
+    entry.connections = 0;
+    entry.tokens = -1;
+    entry.lastRefill = currentTimeMs();
+    ++count;
+    return &entry;
+}
+
+void RateLimiter::rehash(size_t capacity)
+{
+    std::vector<Entry> previous;
+    previous.swap(entries);
+
+    Entry empty;
+    memset(&empty, 0, sizeof(empty));
+    entries.assign(capacity, empty);
+
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < previous.size(); ++i)
+    {
+        if (!previous[i].used)
+        {
+            continue;
+        }
+        size_t idx = hash(previous[i].address) & mask;
+        while (entries[idx].used)
+        {
+            idx = (idx + 1) & mask;
+        }
+        entries[idx] = previous[i];
+    }
+}
+
+// FNV-1a sur les 16 octets de l'adresse
+size_t RateLimiter::hash(const unsigned char* key)
+{
+    unsigned int value = 2166136261u;
+    for (int i = 0; i < 16; ++i)
+    {
+        value ^= key[i];
+        value *= 16777619u;
+    }
+    return value;
+}
+
+long RateLimiter::currentTimeMs()
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec * 1000L + now.tv_usec / 1000;
+}
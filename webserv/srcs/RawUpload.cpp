@@ -0,0 +1,181 @@
+#include "../includes/RawUpload.hpp"
+
+RawUpload::RawUpload(const std::string& uploadDir, const std::string& fileName, bool useSplice, FsyncPolicy fsyncPolicy)
+: uploadDir(uploadDir), fileName(fileName), fileFd(-1), useSplice(useSplice), failed(false), fsyncPolicy(fsyncPolicy)
+{
+    pipeFds[0] = -1;
+    pipeFds[1] = -1;
+}
+
+RawUpload::~RawUpload()
+{
+    abort();
+}
+
+/**************************************************************************
+ *                          METHODES PUBLIQUES                            *
+ * ***********************************************************************/
+
+bool RawUpload::open()
+{
+    std::string pattern = uploadDir + "/.upload-XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+
+    fileFd = mkstemp(&path[0]);
+    if (fileFd < 0)
+    {
+        LOG_ERROR("Impossible de créer le fichier temporaire dans " + uploadDir);
+        return false;
+    }
+    tempPath = &path[0];
+    fchmod(fileFd, 0644);
+
+    // Le pipe sert de tampon noyau entre le socket et le fichier
+    if (useSplice && pipe(pipeFds) != 0)
+    {
+        LOG_WARNING("Création du pipe impossible, réception sans splice pour : " + fileName);
+        pipeFds[0] = -1;
+        pipeFds[1] = -1;
+        useSplice = false;
+    }
+    return true;
+}
+
+bool RawUpload::write(const char* data, size_t length)
+{
+    size_t written = 0;
+    while (written < length)
+    {
+        ssize_t result = ::write(fileFd, data + written, length - written);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            LOG_ERROR("Erreur lors de l'écriture du fichier temporaire : " + tempPath);
+            failed = true;
+            return false;
+        }
+        written += result;
+    }
+    return true;
+}
+
+// Déplace jusqu'à maxBytes octets du socket vers le fichier sans passer par l'espace utilisateur.
+// Renvoie le nombre d'octets déplacés, 0 en fin de flux, -1 en cas d'erreur (errno est conservé).
+ssize_t RawUpload::spliceFrom(int socketFd, size_t maxBytes)
+{
+    size_t chunk = maxBytes < SPLICE_CHUNK_SIZE ? maxBytes : SPLICE_CHUNK_SIZE;
+
+    ssize_t received = splice(socketFd, NULL, pipeFds[1], NULL, chunk, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (received <= 0)
+    {
+        return received;
+    }
+
+    size_t remaining = received;
+    while (remaining > 0)
+    {
+        ssize_t moved = splice(pipeFds[0], NULL, fileFd, NULL, remaining, SPLICE_F_MOVE);
+        if (moved < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            LOG_ERROR("Erreur lors du transfert splice vers le fichier : " + tempPath);
+            failed = true;
+            return -1;
+        }
+        remaining -= moved;
+    }
+    return received;
+}
+
+bool RawUpload::canSplice() const
+{
+    return useSplice;
+}
+
+void RawUpload::disableSplice()
+{
+    LOG_WARNING("splice non supporté, réception via read() pour : " + fileName);
+    closePipe();
+    useSplice = false;
+}
+
+bool RawUpload::hasFailed() const
+{
+    return failed;
+}
+
+bool RawUpload::finish()
+{
+    closePipe();
+
+    if (fsyncPolicy == FSYNC_ALWAYS && fsync(fileFd) != 0)
+    {
+        LOG_ERROR("Échec de fsync pour : " + tempPath);
+        abort();
+        return false;
+    }
+    if (fsyncPolicy == FSYNC_DATA && fdatasync(fileFd) != 0)
+    {
+        LOG_ERROR("Échec de fdatasync pour : " + tempPath);
+        abort();
+        return false;
+    }
+
+    close(fileFd);
+    fileFd = -1;
+
+    std::string target = uploadDir + "/" + fileName;
+    if (std::rename(tempPath.c_str(), target.c_str()) != 0)
+    {
+        LOG_ERROR("Impossible de renommer le fichier temporaire vers " + target);
+        abort();
+        return false;
+    }
+
+    LOG_INFO("Fichier sauvegardé avec succès : " + target);
+    tempPath.clear();
+    return true;
+}
+
+const std::string& RawUpload::getFileName() const
+{
+    return fileName;
+}
+
+/**************************************************************************
+ *                          METHODES PRIVEES                              *
+ * ***********************************************************************/
+
+void RawUpload::closePipe()
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        if (pipeFds[i] != -1)
+        {
+            close(pipeFds[i]);
+            pipeFds[i] = -1;
+        }
+    }
+}
+
+void RawUpload::abort()
+{
+    closePipe();
+    if (fileFd >= 0)
+    {
+        close(fileFd);
+        fileFd = -1;
+    }
+    if (!tempPath.empty())
+    {
+        unlink(tempPath.c_str());
+        tempPath.clear();
+    }
+}
@@ -4,24 +4,43 @@
  *                          CONSTRUCTEUR                                  *
  * ***********************************************************************/
 
-RequestHandler::RequestHandler() : current_port(-1)
+RequestHandler::RequestHandler() : currentServerConfig(NULL), currentTrace(NULL)
 {
 }
 
+RequestHandler::~RequestHandler()
+{
+    clearCgiCaches();
+}
+
 /**************************************************************************
  *                          METHODES PUBLIQUES                            *
  * ***********************************************************************/
 
-void RequestHandler::setServerConfigs(const std::vector<ServerConfig>& configs)
+// Les configurations doivent rester en place tant que le gestionnaire les utilise : les caches sont indexés par leur adresse
+void RequestHandler::setServerConfigs(const std::vector<ServerConfig>& servers, const std::vector<ServerConfig>& locationConfigs)
+{
+    clearCgiCaches();
+    addCgiCaches(servers);
+    addCgiCaches(locationConfigs);
+}
+
+void RequestHandler::setTrace(RequestTrace* trace)
+{
+    currentTrace = trace;
+}
+
+void RequestHandler::markTrace(RequestTrace::Phase phase)
 {
-    serverConfigs = configs;
+    if (currentTrace)
+    {
+        currentTrace->marks[phase] = Clock::monotonic();
+    }
 }
 
-HttpResponse RequestHandler::handleRequest(const HttpRequest& request)
+HttpResponse RequestHandler::handleRequest(const HttpRequest& request, const ServerConfig& serverConfig)
 {
     LOG_INFO("Début du traitement de la requête pour l'URI: " + request.uri);
-    int port = extractPortFromHostHeader(request.headers.find("Host")->second);
-    const ServerConfig& serverConfig = getServerConfigForPort(port);
     currentServerConfig = &serverConfig;
 
     if (!isValidRequest(request))
@@ -47,7 +66,7 @@ HttpResponse RequestHandler::handleRequest(const HttpRequest& request)
         return response;
     }
 
-    if (isCgiRequest(request))
+    if (isCgiRequest(request, serverConfig))
     {
         LOG_INFO("Requête CGI détectée pour l'URI: " + request.uri);
         return handleCgiRequest(request);
@@ -67,6 +86,11 @@ HttpResponse RequestHandler::handleRequest(const HttpRequest& request)
         LOG_INFO("Requête DELETE reçue pour l'URI: " + request.uri);
         return handleDeleteRequest(request);
     }
+    else if (request.method == "PUT")
+    {
+        LOG_INFO("Requête PUT reçue pour l'URI: " + request.uri);
+        return handlePutRequest(request);
+    }
     else
     {
         LOG_ERROR("Méthode non prise en charge: " + request.method + " pour l'URI: " + request.uri);
@@ -74,7 +98,7 @@ HttpResponse RequestHandler::handleRequest(const HttpRequest& request)
         response.httpVersion = "HTTP/1.1";
         response.statusCode = 405;
         response.statusMessage = "Method Not Allowed";
-        response.headers.insert(std::make_pair("Allow", "GET, POST, DELETE"));
+        response.headers.insert(std::make_pair("Allow", "GET, POST, DELETE, PUT"));
         response.body = loadErrorPage(405);
         response.headers.insert(std::make_pair("Content-Type", "text/html"));
         std::ostringstream contentLengthStream;
@@ -154,6 +178,118 @@ std::string RequestHandler::loadErrorPage(int statusCode)
     }
 }
 
+HttpResponse RequestHandler::generateErrorResponse(int statusCode, const std::string& statusMessage)
+{
+    HttpResponse response;
+    response.httpVersion = "HTTP/1.1";
+    response.statusCode = statusCode;
+    response.statusMessage = statusMessage;
+    response.body = loadErrorPage(statusCode);
+    response.headers["Content-Type"] = "text/html";
+
+    std::ostringstream contentLengthStream;
+    contentLengthStream << response.body.size();
+    response.headers["Content-Length"] = contentLengthStream.str();
+
+    return response;
+}
+
+// Les envois multipart hors CGI sont écrits sur disque au fil de la réception plutôt que gardés en mémoire
+MultipartParser* RequestHandler::createUploadParser(const HttpRequest& request, const ServerConfig& serverConfig)
+{
+    if (request.method != "POST" || !isMultipartFormData(request) || isCgiRequest(request, serverConfig))
+    {
+        return NULL;
+    }
+
+    std::string boundary = getBoundary(request.getHeader("Content-Type"));
+    if (boundary.empty())
+    {
+        return NULL;
+    }
+
+    std::string uploadsDirPath = getUploadDirectory();
+    if (uploadsDirPath.empty())
+    {
+        return NULL;
+    }
+
+    LOG_INFO("Réception en flux du corps multipart vers : " + uploadsDirPath);
+    return new MultipartParser(boundary, uploadsDirPath);
+}
+
+// Les corps bruts (PUT, ou POST hors formulaire) sont écrits tels quels dans uploads/ sous le nom de la ressource
+RawUpload* RequestHandler::createRawUpload(const HttpRequest& request, const ServerConfig& serverConfig)
+{
+    if (request.method != "PUT" && request.method != "POST")
+    {
+        return NULL;
+    }
+    if (isCgiRequest(request, serverConfig))
+    {
+        return NULL;
+    }
+    if (request.method == "POST")
+    {
+        std::string contentType = request.getHeader("Content-Type");
+        if (contentType.empty() || isMultipartFormData(request) || contentType.find("application/x-www-form-urlencoded") != std::string::npos)
+        {
+            return NULL;
+        }
+    }
+
+    std::string path = request.uri.substr(0, request.uri.find('?'));
+    std::string fileName = urlDecode(path.substr(path.find_last_of('/') + 1));
+    if (fileName.empty() || fileName == "." || fileName == ".." || fileName.find('/') != std::string::npos)
+    {
+        return NULL;
+    }
+
+    if (isMethodDenied(request.method, serverConfig))
+    {
+        return NULL;
+    }
+
+    std::string uploadsDirPath = getUploadDirectory();
+    if (uploadsDirPath.empty())
+    {
+        return NULL;
+    }
+
+    RawUpload* upload = new RawUpload(uploadsDirPath, fileName, serverConfig.upload_splice, serverConfig.upload_fsync);
+    if (!upload->open())
+    {
+        delete upload;
+        return NULL;
+    }
+
+    LOG_INFO("Réception brute du corps vers : " + uploadsDirPath + "/" + fileName);
+    return upload;
+}
+
+// Limite de taille du corps du bloc server ou location résolu, 0 si aucune limite n'est configurée
+size_t RequestHandler::getMaxBodySize(const ServerConfig& serverConfig)
+{
+    return serverConfig.client_max_body_size > 0 ? static_cast<size_t>(serverConfig.client_max_body_size) : 0;
+}
+
+// Contrôles applicables avant la réception du corps ; la limite de taille est appliquée par la couche connexion
+bool RequestHandler::validateHeaders(const HttpRequest& request, const ServerConfig& serverConfig, HttpResponse& errorResponse)
+{
+    if (!isValidRequest(request))
+    {
+        errorResponse = generateErrorResponse(400, "Bad Request");
+        return false;
+    }
+
+    if (isMethodDenied(request.method, serverConfig))
+    {
+        errorResponse = generateErrorResponse(405, "Method Not Allowed");
+        return false;
+    }
+    return true;
+}
+
 /**************************************************************************
  *                          PARSING REQUETE                               *
  * ***********************************************************************/
@@ -166,11 +302,9 @@ void RequestHandler::parseRequestLine(const std::string& line, HttpRequest& requ
     std::istringstream stream(line);
     stream >> request.method >> request.uri >> request.httpVersion;
 
-    std::ostringstream logMessage;
-    logMessage << "Méthode : " << request.method
-            << ", URI : " << request.uri
-            << ", Version HTTP : " << request.httpVersion;
-    LOG_INFO(logMessage.str());
+    LOG_INFO("Méthode : " + request.method
+            + ", URI : " + request.uri
+            + ", Version HTTP : " + request.httpVersion);
 
     LOG_INFO("pFin de l'analyse de la ligne de requête");
 }
@@ -193,9 +327,7 @@ void RequestHandler::parseHeaders(std::istringstream& stream, HttpRequest& reque
             }
             request.headers[key] = value;
 
-            std::ostringstream logMessage;
-            logMessage << "En-tête trouvé : " << key << " : " << value;
-            LOG_INFO(logMessage.str());
+            LOG_INFO("En-tête trouvé : " + key + " : " + value);
         }
     }
 
@@ -219,17 +351,6 @@ void RequestHandler::parseBody(HttpRequest& request)
             }
         }
     }
-    else if (isMultipartFormData(request))
-    {
-        std::string contentType = request.headers["Content-Type"];
-        std::string boundary = getBoundary(contentType);
-        
-        if (!boundary.empty())
-        {
-            std::vector<FilePart> files;
-            parseMultipartFormData(request.body, boundary, files);
-        }
-    }
 }
 
 /**************************************************************************
@@ -238,7 +359,7 @@ void RequestHandler::parseBody(HttpRequest& request)
 
 bool RequestHandler::isValidRequest(const HttpRequest& request)
 {
-    if(request.method != "GET" && request.method != "POST" && request.method != "DELETE")
+    if(request.method != "GET" && request.method != "POST" && request.method != "DELETE" && request.method != "PUT")
     {
         LOG_ERROR("Méthode HTTP non supportée: " + request.method);
         return false;
@@ -332,12 +453,9 @@ HttpResponse RequestHandler::handleGetRequest(const HttpRequest& request)
 {
     HttpResponse response;
 
-    std::string hostHeader = request.headers.find("Host") != request.headers.end() ? request.headers.find("Host")->second : "";
-    int port = extractPortFromHostHeader(hostHeader);
-
     try
     {
-        const ServerConfig& serverConfig = getServerConfigForPort(port);
+        const ServerConfig& serverConfig = *currentServerConfig;
         std::string fullPath = serverConfig.root + request.uri;
 
         if (fullPath[fullPath.size() - 1] == '/')
@@ -350,9 +468,12 @@ HttpResponse RequestHandler::handleGetRequest(const HttpRequest& request)
         {
             if (S_ISREG(pathStat.st_mode))
             {
+                struct timeval readStart;
+                gettimeofday(&readStart, NULL);
                 std::ifstream file(fullPath.c_str(), std::ios::binary);
                 std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
                 file.close();
+                Metrics::getInstance().observe(Metrics::STATIC_FILE_DURATION, Metrics::elapsedMicros(readStart));
 
                 response.body = content;
                 response.httpVersion = "HTTP/1.1";
@@ -459,15 +580,10 @@ HttpResponse RequestHandler::handlePostRequest(const HttpRequest& request)
         std::string contentType = request.headers.find("Content-Type")->second;
         std::string boundary = getBoundary(contentType);
 
+        // Les fichiers ont déjà été écrits dans uploads/ pendant la réception du corps
         if (!boundary.empty())
         {
-            std::vector<FilePart> files;
-            parseMultipartFormData(request.body, boundary, files);
-
-            for (size_t i = 0; i < files.size(); ++i)
-            {
-                saveFile(files[i].fileContent, files[i].fileName);
-            }
+            LOG_INFO_STREAM(request.uploadedFiles.size() << " fichier(s) reçu(s) pour l'URI: " << request.uri);
 
             response.httpVersion = "HTTP/1.1";
             response.statusCode = 200;
@@ -483,6 +599,14 @@ HttpResponse RequestHandler::handlePostRequest(const HttpRequest& request)
             response.body = loadErrorPage(400);
             response.headers["Content-Type"] = "text/html";
         }
+
+        std::ostringstream oss;
+        oss << response.body.length();
+        response.headers["Content-Length"] = oss.str();
+    }
+    else if (!request.uploadedFiles.empty())
+    {
+        return handlePutRequest(request);
     }
     else
     {
@@ -515,22 +639,47 @@ HttpResponse RequestHandler::handlePostRequest(const HttpRequest& request)
     return response;
 }
 
+HttpResponse RequestHandler::handlePutRequest(const HttpRequest& request)
+{
+    HttpResponse response;
+
+    // Le corps a déjà été écrit dans uploads/ pendant la réception
+    if (!request.uploadedFiles.empty())
+    {
+        LOG_INFO("Fichier reçu pour l'URI: " + request.uri + " -> " + request.uploadedFiles.front());
+        response.httpVersion = "HTTP/1.1";
+        response.statusCode = 201;
+        response.statusMessage = "Created";
+        response.body = "<html><body><h1>File Uploaded Successfully</h1></body></html>";
+        response.headers["Content-Type"] = "text/html";
+
+        std::ostringstream oss;
+        oss << response.body.length();
+        response.headers["Content-Length"] = oss.str();
+        return response;
+    }
+
+    LOG_ERROR("Aucun fichier n'a pu être reçu pour l'URI: " + request.uri);
+    return generateErrorResponse(400, "Bad Request");
+}
+
 /**************************************************************************
  *                          GESTION DES CGI                               *
  * ***********************************************************************/
 
-bool RequestHandler::isCgiRequest(const HttpRequest& request)
+// Les extensions CGI viennent de la directive cgi_ext du bloc server ou de la location qui sert la requête
+bool RequestHandler::isCgiRequest(const HttpRequest& request, const ServerConfig& serverConfig)
 {
     LOG_INFO("isCgiRequest called with URI: " + request.uri);
 
-    std::string uri = request.uri;
-    size_t lastDotPos = uri.find_last_of(".");
+    std::string path = request.uri.substr(0, request.uri.find('?'));
+    size_t lastDotPos = path.find_last_of(".");
 
-    if (lastDotPos != std::string::npos)
+    if (lastDotPos != std::string::npos && path.find('/', lastDotPos) == std::string::npos)
     {
-        std::string extension = uri.substr(lastDotPos);
+        std::string extension = path.substr(lastDotPos);
         LOG_INFO("Extension extracted: " + extension);
-        if (extension == ".cgi" || extension == ".pl" || extension == ".php" || extension == ".py")
+        if (std::find(serverConfig.cgi_ext.begin(), serverConfig.cgi_ext.end(), extension) != serverConfig.cgi_ext.end())
         {
             LOG_INFO("Request identified as CGI.");
             return true;
@@ -547,26 +696,52 @@ HttpResponse RequestHandler::handleCgiRequest(const HttpRequest& request)
 
     try
     {
-        int port = extractPortFromHostHeader(request.headers.find("Host")->second);
-
-        std::ostringstream portStream;
-        portStream << port;
-
-        LOG_INFO("Configuration du serveur récupérée pour le port: " + portStream.str());
-
-
         std::string scriptPath = getScriptPathFromUri(request.uri);
         if (scriptPath.empty())
         {
             return generateNotFoundResponse();
         }
+        if (currentTrace)
+        {
+            currentTrace->script = scriptPath;
+        }
+
+        // Le micro-cache ne concerne que GET : la réponse ne dépend que de l'URI et des en-têtes de la clé
+        CgiCache* cache = NULL;
+        std::string cacheKey;
+        std::map<const ServerConfig*, CgiCache*>::iterator cacheIt = cgiCaches.find(currentServerConfig);
+        if (cacheIt != cgiCaches.end() && request.method == "GET")
+        {
+            cache = cacheIt->second;
+            cacheKey = cache->buildKey(request, currentServerConfig->cgi_cache_key_headers);
+
+            HttpResponse cached;
+            if (cache->lookup(cacheKey, cached))
+            {
+                LOG_INFO("Réponse CGI servie depuis le cache pour l'URI: " + request.uri);
+                Metrics::getInstance().increment(Metrics::CGI_CACHE_HITS);
+                cached.headers["X-Cache"] = "HIT";
+                return cached;
+            }
+            Metrics::getInstance().increment(Metrics::CGI_CACHE_MISSES);
+        }
 
         CgiHandler cgiHandler(scriptPath, request, *this);
         LOG_INFO("CgiHandler construit avec scriptPath: " + scriptPath);
 
+        struct timeval scriptStart;
+        gettimeofday(&scriptStart, NULL);
         HttpResponse response = cgiHandler.executeScript();
+        Metrics::getInstance().increment(Metrics::CGI_EXECUTIONS);
+        Metrics::getInstance().observe(Metrics::CGI_DURATION, Metrics::elapsedMicros(scriptStart));
         LOG_INFO("Script CGI exécuté, préparation de la réponse HTTP");
 
+        if (cache)
+        {
+            cache->store(cacheKey, response);
+            response.headers["X-Cache"] = "MISS";
+        }
+
         return response;
     }
     catch (const std::exception& e)
@@ -603,6 +778,28 @@ std::string RequestHandler::getScriptPathFromUri(const std::string& uri)
     }
 }
 
+void RequestHandler::addCgiCaches(const std::vector<ServerConfig>& configs)
+{
+    for (std::vector<ServerConfig>::const_iterator it = configs.begin(); it != configs.end(); ++it)
+    {
+        if (it->cgi_cache)
+        {
+            cgiCaches[&(*it)] = new CgiCache(static_cast<size_t>(it->cgi_cache_max_size), it->cgi_cache_ttl);
+
+            LOG_INFO_STREAM("Cache CGI activé pour le port " << it->port);
+        }
+    }
+}
+
+void RequestHandler::clearCgiCaches()
+{
+    for (std::map<const ServerConfig*, CgiCache*>::iterator it = cgiCaches.begin(); it != cgiCaches.end(); ++it)
+    {
+        delete it->second;
+    }
+    cgiCaches.clear();
+}
+
 /**************************************************************************
  *                        GESTION DES REDIRECTIONS                        *
  * ***********************************************************************/
@@ -611,8 +808,7 @@ HttpResponse RequestHandler::handleGetRequestWithRedirection(const HttpRequest&
 {
     LOG_INFO("Début du traitement de la requête GET avec vérification des redirections pour l'URI: " + request.uri);
 
-    int port = extractPortFromHostHeader(request.headers.find("Host")->second);
-    const ServerConfig& serverConfig = getServerConfigForPort(port);
+    const ServerConfig& serverConfig = *currentServerConfig;
 
     std::map<std::string, std::string>::const_iterator redirectionIt = serverConfig.redirections.find(request.uri);
     if (redirectionIt != serverConfig.redirections.end())
@@ -629,62 +825,6 @@ HttpResponse RequestHandler::handleGetRequestWithRedirection(const HttpRequest&
     return handleGetRequest(request);
 }
 
-/**************************************************************************
- *                    GESTION DE LA CONFIGURATION                         *
- * ***********************************************************************/
-
-void RequestHandler::setServerPort(int port)
-{
-    std::ostringstream oldPortMessage;
-    oldPortMessage << "Ancien port du serveur : " << current_port;
-    LOG_INFO(oldPortMessage.str());
-
-    current_port = port;
-
-    std::ostringstream newPortMessage;
-    newPortMessage << "Nouveau port du serveur mis à jour : " << port;
-    LOG_INFO(newPortMessage.str());
-}
-
-int RequestHandler::extractPortFromHostHeader(const std::string& hostHeader)
-{
-    size_t colonPos = hostHeader.find_last_of(':');
-    if (colonPos != std::string::npos)
-    {
-        std::istringstream portStrStream(hostHeader.substr(colonPos + 1));
-        int port;
-        portStrStream >> port;
-        std::stringstream ss;
-        ss << port;
-        LOG_INFO("Port extracted from host header: " + ss.str());
-        return port;
-    }
-    LOG_INFO("Default port 3000 used");
-    return 3000;
-}
-
-ServerConfig RequestHandler::getServerConfigForPort(int port)
-{
-    for (std::vector<ServerConfig>::iterator it = serverConfigs.begin(); it != serverConfigs.end(); ++it)
-    {
-        if (it->port == port)
-        {
-            std::stringstream ss;
-            ss << port;
-            std::string logMessage = "Server config found for port: " + ss.str();
-            LOG_INFO(logMessage.c_str());
-            return *it;
-        }
-    }
-
-    std::stringstream ss;
-    ss << port;
-    std::string logErrorMessage = "Server config not found for port: " + ss.str();
-    LOG_ERROR(logErrorMessage.c_str());
-    
-    throw std::runtime_error("Server config not found for port: " + ss.str());
-}
-
 /**************************************************************************
  *               GESTION DES DONNEES DE FORMULAIRE                        *
  * ***********************************************************************/
@@ -772,7 +912,11 @@ std::string RequestHandler::getBoundary(const std::string& contentType)
     std::string::size_type pos = contentType.find("boundary=");
     if (pos != std::string::npos)
     {
-        std::string boundary = contentType.substr(pos + 9);
+        std::string boundary = contentType.substr(pos + 9, contentType.find(';', pos) - pos - 9);
+        if (boundary.size() >= 2 && boundary[0] == '"' && boundary[boundary.size() - 1] == '"')
+        {
+            boundary = boundary.substr(1, boundary.size() - 2);
+        }
         LOG_INFO("Boundary trouvé: " + boundary);
         return boundary;
     }
@@ -781,36 +925,6 @@ std::string RequestHandler::getBoundary(const std::string& contentType)
     return "";
 }
 
-void RequestHandler::parseMultipartFormData(const std::string& body, const std::string& boundary, std::vector<FilePart>& files)
-{
-    LOG_INFO("Début de parseMultipartFormData");
-
-    std::string delimiter = "--" + boundary;
-    std::string endDelimiter = delimiter + "--";
-    std::size_t pos = 0, endPos = 0;
-
-    while ((pos = body.find(delimiter, pos)) != std::string::npos)
-    {
-        endPos = body.find(delimiter, pos + delimiter.length());
-
-        if (endPos == std::string::npos)
-            break;
-
-        std::string part = body.substr(pos + delimiter.length(), endPos - pos - delimiter.length());
-        FilePart filePart = extractFilePart(part);
-
-        if (!filePart.fileName.empty())
-        {
-            LOG_INFO("Fichier extrait: " + filePart.fileName);
-            files.push_back(filePart);
-        }
-
-        pos = endPos + delimiter.length();
-    }
-
-    LOG_INFO("Fin de parseMultipartFormData");
-}
-
 std::string RequestHandler::generateDirectoryListingHtml(const std::string& directoryPath)
 {
     DIR* dir = opendir(directoryPath.c_str());
@@ -854,13 +968,13 @@ std::string RequestHandler::generateDirectoryListingHtml(const std::string& dire
  *                   GESTION DES FICHIERS                                 *
  * ***********************************************************************/
 
-void RequestHandler::saveFile(const std::string& content, const std::string& fileName)
+std::string RequestHandler::getUploadDirectory()
 {
     const char* baseDir = std::getenv("PWD");
     if (!baseDir)
     {
         LOG_ERROR("PWD non défini, impossible de déterminer le chemin de base pour sauvegarder le fichier");
-        return;
+        return "";
     }
 
     std::string uploadsDirPath = std::string(baseDir) + "/uploads";
@@ -871,90 +985,21 @@ void RequestHandler::saveFile(const std::string& content, const std::string& fil
         if (mkdir(uploadsDirPath.c_str(), 0777) != 0)
         {
             LOG_ERROR("Impossible de créer le répertoire uploads : " + uploadsDirPath);
-            return;
+            return "";
         }
     }
     else if (!S_ISDIR(statbuf.st_mode))
     {
         LOG_ERROR("Le chemin existe mais n'est pas un répertoire : " + uploadsDirPath);
-        return;
-    }
-
-    std::string filePath = uploadsDirPath + "/" + fileName;
-
-    std::ofstream file(filePath.c_str(), std::ios::out | std::ios::binary);
-    if (file.is_open())
-    {
-        file.write(content.c_str(), content.size());
-        file.close();
-        LOG_INFO("Fichier sauvegardé avec succès : " + filePath);
-    }
-    else
-    {
-        LOG_ERROR("Erreur lors de l'ouverture du fichier pour écriture : " + filePath);
-    }
-}
-
-FilePart RequestHandler::extractFilePart(const std::string& part)
-{
-    FilePart filePart;
-    std::istringstream partStream(part);
-    std::string line;
-    std::string contentDisposition;
-    bool contentStart = false;
-
-    while (std::getline(partStream, line))
-    {
-        if (!line.empty() && line[line.size() - 1] == '\r')
-        {
-            line.erase(line.size() - 1);
-        }
-
-        if (line.empty())
-        {
-            contentStart = true;
-            LOG_INFO("Début du contenu du fichier détecté.");
-            continue;
-        }
-
-        if (!contentStart)
-        {
-            if (line.find("Content-Disposition:") != std::string::npos)
-            {
-                contentDisposition = line;
-                LOG_INFO("Content-Disposition trouvé : " + line);
-                std::size_t filenamePos = line.find("filename=\"");
-                if (filenamePos != std::string::npos)
-                {
-                    filenamePos += 10;
-                    std::size_t filenameEnd = line.find("\"", filenamePos);
-                    if (filenameEnd != std::string::npos)
-                    {
-                        filePart.fileName = line.substr(filenamePos, filenameEnd - filenamePos);
-                        LOG_INFO("Nom du fichier extrait : " + filePart.fileName);
-                    }
-                }
-            }
-        }
-        else
-        {
-            filePart.fileContent += line + "\n";
-        }
-    }
-
-    if (!filePart.fileContent.empty())
-    {
-        filePart.fileContent.erase(filePart.fileContent.size() - 1);
+        return "";
     }
 
-    LOG_INFO("Extraction du fichier terminée. Nom du fichier : " + filePart.fileName);
-    return filePart;
+    return uploadsDirPath;
 }
 
-std::string RequestHandler::getAbsolutePath(const std::string& uri, int port)
+std::string RequestHandler::getAbsolutePath(const std::string& uri)
 {
-    const ServerConfig& config = getServerConfigForPort(port);
-    std::string basePath = config.root;
+    std::string basePath = currentServerConfig->root;
     std::string fullPath = basePath + uri;
 
     std::string normalizedPath = normalizePath(fullPath);
@@ -82,6 +82,11 @@ std::string Response::buildHttpResponse(const HttpResponse& response)
 
     LOG_INFO("Ajout des en-têtes HTTP à la réponse");
 
+    if (response.headers.find("Date") == response.headers.end())
+    {
+        respStream << "Date: " << Clock::getInstance().httpDate() << "\r\n";
+    }
+
     for (std::map<std::string, std::string>::const_iterator it = response.headers.begin(); it != response.headers.end(); ++it) {
         if (it->first != "Status")
         {
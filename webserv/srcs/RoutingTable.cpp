@@ -0,0 +1,235 @@
+#include "../includes/RoutingTable.hpp"
+
+RoutingTable::RoutingTable(const std::vector<ServerConfig>& servers, const std::vector<ServerConfig>& locationConfigs)
+: servers(servers), locationConfigs(locationConfigs)
+{
+    // Un arbre des chemins (exacts et préfixes) et un arbre des extensions par bloc server
+    for (size_t i = 0; i < this->servers.size(); ++i)
+    {
+        LocationTree* paths = new LocationTree();
+        LocationTree* extensions = new LocationTree();
+
+        const std::vector<LocationConfig>& locations = this->servers[i].locations;
+        for (size_t j = 0; j < locations.size(); ++j)
+        {
+            const ServerConfig* config = &this->locationConfigs[locations[j].configIndex];
+            bool inserted;
+            if (locations[j].match == LOCATION_EXTENSION)
+                inserted = extensions->insert(locations[j].path, config, true);
+            else
+                inserted = paths->insert(locations[j].path, config, locations[j].match == LOCATION_EXACT);
+
+            if (!inserted)
+            {
+                LOG_WARNING("Bloc location dupliqué ignoré : " + locations[j].path);
+            }
+        }
+        pathTrees.push_back(paths);
+        extensionTrees.push_back(extensions);
+
+        // allowed_ips et denied_ips sont compilés une fois par génération de configuration
+        AccessList* accessList = NULL;
+        const ServerConfig& server = this->servers[i];
+        if (!server.allowed_ips.empty() || !server.denied_ips.empty())
+        {
+            accessList = new AccessList();
+            for (size_t j = 0; j < server.allowed_ips.size(); ++j)
+                accessList->add(server.allowed_ips[j], true);
+            for (size_t j = 0; j < server.denied_ips.size(); ++j)
+                accessList->add(server.denied_ips[j], false);
+        }
+        accessLists.push_back(accessList);
+    }
+}
+
+RoutingTable::~RoutingTable()
+{
+    for (size_t i = 0; i < pathTrees.size(); ++i)
+    {
+        delete pathTrees[i];
+        delete extensionTrees[i];
+        delete accessLists[i];
+    }
+    routes.clear();
+    defaultServers.clear();
+    listenerServers.clear();
+}
+
+/**************************************************************************
+ *                          METHODES PUBLIQUES                            *
+ * ***********************************************************************/
+
+// Associe un bloc server à un socket d'écoute ; le premier bloc enregistré devient le serveur par défaut.
+// Seuls les blocs joignables (par défaut ou par au moins un nom) comptent pour le filtrage à l'acceptation
+void RoutingTable::addListener(int listenFd, size_t serverIndex)
+{
+    const ServerConfig* serverConfig = &servers[serverIndex];
+    bool reachable = false;
+
+    if (defaultServers.find(listenFd) == defaultServers.end())
+    {
+        defaultServers[listenFd] = serverConfig;
+        reachable = true;
+    }
+
+    for (size_t i = 0; i < serverConfig->server_names.size(); ++i)
+    {
+        std::string key = makeKey(listenFd, serverConfig->server_names[i]);
+        if (routes.find(key) == routes.end())
+        {
+            routes[key] = serverConfig;
+            reachable = true;
+            LOG_INFO("Route virtuelle enregistrée : " + key);
+        }
+    }
+
+    if (reachable)
+    {
+        listenerServers[listenFd].push_back(serverConfig);
+    }
+}
+
+// Le Host est cherché tel quel puis sans son port ; à défaut on retombe sur le serveur par défaut de l'écoute
+const ServerConfig* RoutingTable::resolve(int listenFd, const std::string& hostHeader) const
+{
+    if (!hostHeader.empty())
+    {
+        std::map<std::string, const ServerConfig*>::const_iterator it = routes.find(makeKey(listenFd, hostHeader));
+        if (it != routes.end())
+        {
+            return it->second;
+        }
+
+        std::string::size_type colonPos = hostHeader.find_last_of(':');
+        if (colonPos != std::string::npos && hostHeader.find(']', colonPos) == std::string::npos)
+        {
+            it = routes.find(makeKey(listenFd, hostHeader.substr(0, colonPos)));
+            if (it != routes.end())
+            {
+                return it->second;
+            }
+        }
+    }
+
+    std::map<int, const ServerConfig*>::const_iterator defaultIt = defaultServers.find(listenFd);
+    if (defaultIt != defaultServers.end())
+    {
+        return defaultIt->second;
+    }
+
+    LOG_ERROR("Aucun serveur configuré pour ce socket d'écoute, Host: " + hostHeader);
+    return NULL;
+}
+
+// Priorité : correspondance exacte, puis extension, puis plus long préfixe ; sans location le bloc server s'applique
+const ServerConfig* RoutingTable::resolveLocation(const ServerConfig* serverConfig, const std::string& uri) const
+{
+    if (!serverConfig || serverConfig->locations.empty())
+    {
+        return serverConfig;
+    }
+
+    size_t index = serverConfig - &servers[0];
+    std::string path = uri.substr(0, uri.find('?'));
+
+    const ServerConfig* location = pathTrees[index]->findExact(path);
+    if (location)
+    {
+        return location;
+    }
+
+    std::string::size_type dotPos = path.find_last_of('.');
+    if (dotPos != std::string::npos && path.find('/', dotPos) == std::string::npos)
+    {
+        location = extensionTrees[index]->findExact(path.substr(dotPos));
+        if (location)
+        {
+            return location;
+        }
+    }
+
+    location = pathTrees[index]->findLongestPrefix(path);
+    return location ? location : serverConfig;
+}
+
+// Vérifié juste après accept(), avant toute lecture : la connexion n'est refusée que si tous les blocs server
+// de l'écoute refusent l'adresse, le Host décidant ensuite pour le bloc effectivement demandé
+bool RoutingTable::isAllowed(int listenFd, const struct sockaddr* address) const
+{
+    std::map<int, std::vector<const ServerConfig*> >::const_iterator it = listenerServers.find(listenFd);
+    unsigned char key[16];
+    if (it == listenerServers.end() || !AccessList::makeKey(address, key))
+    {
+        return true;
+    }
+
+    for (size_t i = 0; i < it->second.size(); ++i)
+    {
+        const AccessList* accessList = findAccessList(it->second[i]);
+        if (!accessList || accessList->isAllowed(key))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Revérifié une fois le Host connu, pour les serveurs virtuels qui partagent une écoute
+bool RoutingTable::isAllowed(const ServerConfig* serverConfig, const std::string& address) const
+{
+    const AccessList* accessList = findAccessList(serverConfig);
+    unsigned char key[16];
+    if (!accessList || !AccessList::makeKey(address, key))
+    {
+        return true;
+    }
+    return accessList->isAllowed(key);
+}
+
+const std::vector<ServerConfig>& RoutingTable::getServers() const
+{
+    return servers;
+}
+
+const std::vector<ServerConfig>& RoutingTable::getLocationConfigs() const
+{
+    return locationConfigs;
+}
+
+/**************************************************************************
+ *                          METHODES PRIVEES                              *
+ * ***********************************************************************/
+
+const AccessList* RoutingTable::findAccessList(const ServerConfig* serverConfig) const
+{
+    if (servers.empty() || serverConfig < &servers[0] || serverConfig > &servers.back())
+    {
+        return NULL;
+    }
+    return accessLists[serverConfig - &servers[0]];
+}
+
+std::string RoutingTable::makeKey(int listenFd, const std::string& host)
+{
+    char digits[12];
+    int count = 0;
+    unsigned int value = static_cast<unsigned int>(listenFd);
+    do
+    {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    std::string key;
+    key.reserve(count + 1 + host.size());
+    while (count > 0)
+    {
+        key += digits[--count];
+    }
+    key += ' ';
+    for (size_t i = 0; i < host.size(); ++i)
+    {
+        key += static_cast<char>(std::tolower(static_cast<unsigned char>(host[i])));
+    }
+    return key;
+}
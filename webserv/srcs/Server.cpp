@@ -1,143 +1,630 @@
 #include "../includes/Server.hpp"
 
 bool Server::isRunning = true;
+int Server::signalPipe[2] = { -1, -1 };
 
 Server::Server(const std::string& configFilePath, const std::string& logFilePath, Logger::Level logLevel)
-: config(configFilePath, logFilePath, logLevel)
+: max_fd(0), configFilePath(configFilePath), logFilePath(logFilePath), logLevel(logLevel),
+  config(configFilePath, logFilePath, logLevel), routingTable(NULL), draining(false), shuttingDown(false), drainDeadline(0), upgradePipe(-1), upgradePid(-1)
 {
     LOG_INFO("Initialisation du serveur avec le fichier de configuration : " + configFilePath);
     
     config.parse();
-    
-    requestHandler.setServerConfigs(config.getServers());
-    
+
+    FD_ZERO(&master_set);
+    FD_ZERO(&write_set);
+
+    // Self-pipe : ouvert par main() avant l'installation des gestionnaires, un signal reçu pendant le démarrage y attend la boucle
+    if (!openSignalPipe())
+    {
+        shutdownServer("Impossible de créer le pipe des signaux.");
+    }
+    watchFd(signalPipe[0]);
+    adoptInheritedListeners();
+
+    routingTable = new RoutingTable(config.getServers(), config.getLocationConfigs());
+    requestHandler.setServerConfigs(routingTable->getServers(), routingTable->getLocationConfigs());
+    configureLogger();
+    accessLog.configure(routingTable->getServers(), routingTable->getLocationConfigs());
+
     setupServerSockets();
+    notifyUpgradeReady();
 }
 
 Server::~Server()
 {
-    for (size_t i = 0; i < server_fds.size(); ++i)
+    closeAllConnections();
+    reapChildren();
+
+    for (std::map<int, Listener>::iterator it = listeners.begin(); it != listeners.end(); ++it)
+    {
+        it->second.close();
+    }
+    listeners.clear();
+    delete routingTable;
+    for (size_t i = 0; i < retiredTables.size(); ++i)
     {
-        if (server_fds[i] != -1)
+        delete retiredTables[i];
+    }
+    retiredTables.clear();
+
+    for (int i = 0; i < 2; ++i)
+    {
+        if (signalPipe[i] != -1)
         {
-            close(server_fds[i]);
+            close(signalPipe[i]);
+            signalPipe[i] = -1;
         }
     }
-    server_fds.clear();
-    
+
     LOG_INFO("Sockets serveur fermés avec succès.");
 }
 
 void Server::shutdownServer(const std::string& reason)
 {
     LOG_ERROR("Arrêt du serveur en raison de : " + reason);
-    for (size_t i = 0; i < server_fds.size(); ++i) 
+    for (std::map<int, Listener>::iterator it = listeners.begin(); it != listeners.end(); ++it)
     {
-        int fd = server_fds[i];
-        if (fd != -1) close(fd);
+        it->second.close();
     }
 
-    server_fds.clear();
+    listeners.clear();
 
     exit(EXIT_FAILURE);
 }
 
 void Server::setupServerSockets()
 {
-    server_fds.clear();
+    std::map<int, Listener> opened;
+    if (!bindListeners(*routingTable, opened))
+    {
+        shutdownServer("Impossible de démarrer l'écoute sur toutes les adresses requises.");
+    }
+    commitListeners(opened);
+}
 
-    const std::vector<ServerConfig>& servers = config.getServers();
+// Un seul socket par adresse d'écoute : les blocs server qui la partagent sont départagés par le Host.
+// Les adresses déjà ouvertes sont reprises ; en cas d'échec, seuls les sockets ouverts ici sont refermés.
+bool Server::bindListeners(RoutingTable& table, std::map<int, Listener>& result)
+{
+    const std::vector<ServerConfig>& servers = table.getServers();
+    std::map<std::string, int> openedAddresses;
 
     for (size_t i = 0; i < servers.size(); ++i)
     {
-        int fd = socket(AF_INET, SOCK_STREAM, 0);
-        if (fd == -1)
+        Listener listener;
+        if (!listener.resolve(servers[i].host, servers[i].port))
         {
             std::ostringstream oss;
-            oss << "Échec de la création du socket pour le serveur à l'index " << i;
+            oss << "Adresse d'écoute invalide pour le serveur à l'index " << i;
             LOG_ERROR(oss.str());
-            continue; 
+            closeNewListeners(result);
+            return false;
         }
 
-        int opt = 1;
-        if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-            std::ostringstream oss;
-            oss << "Échec de la configuration de SO_REUSEADDR pour le port: " << servers[i].port;
-            LOG_ERROR(oss.str());
-            close(fd);
+        std::map<std::string, int>::iterator existing = openedAddresses.find(listener.getKey());
+        if (existing != openedAddresses.end())
+        {
+            table.addListener(existing->second, i);
+            LOG_INFO("Bloc server rattaché au socket déjà ouvert sur " + listener.getKey());
             continue;
         }
 
-        struct sockaddr_in serverAddr;
-        memset(&serverAddr, 0, sizeof(serverAddr));
-        serverAddr.sin_family = AF_INET;
-        serverAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-        serverAddr.sin_port = htons(static_cast<uint16_t>(servers[i].port));
+        int currentFd = findListener(listener.getKey());
+        if (currentFd != -1)
+        {
+            // Le descripteur appartient encore à la génération courante : un échec ne doit pas le fermer
+            listener = listeners[currentFd];
+            if (!listener.configure(servers[i]))
+            {
+                closeNewListeners(result);
+                return false;
+            }
+        }
+        else if (!listener.open(servers[i]))
+        {
+            closeNewListeners(result);
+            return false;
+        }
+
+        result[listener.getFd()] = listener;
+        openedAddresses[listener.getKey()] = listener.getFd();
+        table.addListener(listener.getFd(), i);
+
+        LOG_INFO("Socket serveur configuré et en écoute sur " + listener.getKey());
+    }
+    return true;
+}
 
-        if (bind(fd, (struct sockaddr *)&serverAddr, sizeof(serverAddr)) < 0)
+// Remplace l'ensemble des sockets d'écoute ; les connexions d'une écoute supprimée finissent leur requête puis sont fermées
+void Server::commitListeners(std::map<int, Listener>& next)
+{
+    for (std::map<int, Listener>::iterator it = listeners.begin(); it != listeners.end(); ++it)
+    {
+        if (next.find(it->first) != next.end())
         {
-            std::ostringstream oss;
-            oss << "Échec du bind sur le port: " << servers[i].port;
-            LOG_ERROR(oss.str());
-            close(fd);
             continue;
         }
 
-        if (listen(fd, 100) < 0)
+        LOG_INFO("Fermeture du socket d'écoute " + it->second.getKey());
+        FD_CLR(it->first, &master_set);
+        it->second.close();
+
+        std::vector<int> idle;
+        for (std::map<int, Connection>::iterator conn = connections.begin(); conn != connections.end(); ++conn)
         {
-            std::ostringstream oss;
-            oss << "Échec de l'écoute sur le port: " << servers[i].port;
-            LOG_ERROR(oss.str());
-            shutdownServer("Impossible de démarrer l'écoute sur tous les ports requis.");
+            if (conn->second.listenFd != it->first)
+            {
+                continue;
+            }
+            conn->second.listenFd = -1;
+            if (conn->second.state == Connection::READING_HEADERS && conn->second.buffer.empty() && conn->second.output.empty())
+            {
+                idle.push_back(conn->first);
+            }
+        }
+        for (size_t i = 0; i < idle.size(); ++i)
+        {
+            closeConnection(idle[i]);
         }
+    }
 
-        server_fds.push_back(fd);
+    for (std::map<int, Listener>::iterator it = next.begin(); it != next.end(); ++it)
+    {
+        watchFd(it->first);
+    }
+    listeners = next;
+}
 
-        std::ostringstream oss;
-        oss << "Socket serveur configuré et en écoute sur le port " << servers[i].port;
-        LOG_INFO(oss.str());
+void Server::closeNewListeners(std::map<int, Listener>& opened)
+{
+    for (std::map<int, Listener>::iterator it = opened.begin(); it != opened.end(); ++it)
+    {
+        if (listeners.find(it->first) == listeners.end())
+        {
+            it->second.close();
+        }
     }
+    opened.clear();
 }
 
-void Server::safeWrite(int fd, const std::string& data)
+int Server::findListener(const std::string& key) const
 {
-    ssize_t totalWritten = 0;
-    ssize_t dataLength = data.size();
-    const char* dataPtr = data.c_str();
+    for (std::map<int, Listener>::const_iterator it = listeners.begin(); it != listeners.end(); ++it)
+    {
+        if (it->second.getKey() == key)
+        {
+            return it->first;
+        }
+    }
+    return -1;
+}
 
-    while (totalWritten < dataLength)
+void Server::watchFd(int fd)
+{
+    FD_SET(fd, &master_set);
+    if (fd > max_fd)
     {
-        ssize_t bytesWritten = write(fd, dataPtr + totalWritten, dataLength - totalWritten);
-        if (bytesWritten < 0)
+        max_fd = fd;
+    }
+}
+
+/**************************************************************************
+ *                       SIGNAUX ET RECHARGEMENT                          *
+ * ***********************************************************************/
+
+// Les gestionnaires de signaux se contentent d'écrire dans ce pipe, la boucle select() fait le reste
+bool Server::openSignalPipe()
+{
+    if (signalPipe[0] != -1)
+    {
+        return true;
+    }
+    return pipe2(signalPipe, O_NONBLOCK | O_CLOEXEC) == 0;
+}
+
+// Appelée depuis un gestionnaire de signal : uniquement des opérations async-signal-safe
+void Server::notifySignal(int signum)
+{
+    if (signalPipe[1] != -1)
+    {
+        int savedErrno = errno;
+        unsigned char byte = static_cast<unsigned char>(signum);
+        ssize_t ignored = write(signalPipe[1], &byte, 1);
+        (void)ignored;
+        errno = savedErrno;
+    }
+}
+
+void Server::handleSignals()
+{
+    unsigned char signals[64];
+    ssize_t count;
+
+    while ((count = read(signalPipe[0], signals, sizeof(signals))) > 0)
+    {
+        for (ssize_t i = 0; i < count; ++i)
         {
-            if (errno == EINTR)
+            if (signals[i] == SIGHUP && !draining)
             {
-                continue;
+                reloadConfiguration();
+            }
+            else if (signals[i] == SIGUSR1)
+            {
+                accessLog.reopen();
+                Logger::getInstance().configure(logFilePath, logLevel);
+                LOG_INFO("SIGUSR1 reçu, fichiers journaux rouverts.");
+            }
+            else if (signals[i] == SIGUSR2 && !draining)
+            {
+                startUpgrade();
+            }
+            else if (signals[i] == SIGINT || signals[i] == SIGTERM)
+            {
+                beginShutdown();
             }
-            LOG_ERROR("Échec de l'envoi des données au client.");
-            close(fd);
-            return;
         }
-        totalWritten += bytesWritten;
     }
 }
 
-void Server::start()
+// Nouvelle génération de configuration : analysée et validée à part, elle ne remplace l'ancienne que si tout a réussi.
+// Les requêtes en cours terminent sur l'ancienne génération, libérée dès qu'aucune connexion ne la référence.
+void Server::reloadConfiguration()
 {
-    fd_set master_set, read_fds;
-    int max_fd = 0;
+    LOG_INFO("SIGHUP reçu, rechargement de la configuration : " + configFilePath);
 
-    FD_ZERO(&master_set);
-    for (std::vector<int>::iterator it = server_fds.begin(); it != server_fds.end(); ++it)
+    ConfigParser parser(configFilePath, logFilePath, logLevel);
+    try
+    {
+        parser.parse();
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR(std::string("Rechargement annulé, configuration illisible : ") + e.what());
+        return;
+    }
+    if (parser.getServers().empty())
+    {
+        LOG_ERROR("Rechargement annulé : aucun bloc 'server' dans la nouvelle configuration.");
+        return;
+    }
+
+    RoutingTable* table = new RoutingTable(parser.getServers(), parser.getLocationConfigs());
+    std::map<int, Listener> nextListeners;
+    if (!bindListeners(*table, nextListeners))
+    {
+        LOG_ERROR("Rechargement annulé, la configuration précédente reste active.");
+        delete table;
+        return;
+    }
+
+    commitListeners(nextListeners);
+    retiredTables.push_back(routingTable);
+    routingTable = table;
+    requestHandler.setServerConfigs(routingTable->getServers(), routingTable->getLocationConfigs());
+    config = parser;
+    configureLogger();
+    accessLog.configure(routingTable->getServers(), routingTable->getLocationConfigs());
+    releaseRetiredTables();
+
+    LOG_INFO("Configuration rechargée avec succès.");
+}
+
+// SIGINT/SIGTERM : vidage dans la limite de shutdown_timeout ; un second signal interrompt immédiatement les connexions
+void Server::beginShutdown()
+{
+    if (shuttingDown)
+    {
+        LOG_WARNING("Second signal d'arrêt reçu, fermeture immédiate des connexions.");
+        closeAllConnections();
+        isRunning = false;
+        return;
+    }
+
+    shuttingDown = true;
+    std::ostringstream oss;
+    oss << "Signal d'arrêt reçu, vidage de " << connections.size() << " connexion(s) (délai maximal " << getShutdownTimeout() << " s).";
+    LOG_WARNING(oss.str());
+    beginDrain(false);
+}
+
+// Le délai retenu est le plus long des blocs server qui le fixent, DEFAULT_SHUTDOWN_TIMEOUT sinon
+int Server::getShutdownTimeout() const
+{
+    int timeout = -1;
+    const std::vector<ServerConfig>& servers = routingTable->getServers();
+    for (size_t i = 0; i < servers.size(); ++i)
+    {
+        if (servers[i].shutdown_timeout > timeout)
+        {
+            timeout = servers[i].shutdown_timeout;
+        }
+    }
+    return timeout >= 0 ? timeout : DEFAULT_SHUTDOWN_TIMEOUT;
+}
+
+void Server::closeAllConnections()
+{
+    while (!connections.empty())
+    {
+        closeConnection(connections.begin()->first);
+    }
+}
+
+// Récupère les processus fils terminés (CGI, nouveau binaire qui n'a pas démarré) sans attendre ceux encore actifs
+void Server::reapChildren()
+{
+    int status;
+    while (waitpid(-1, &status, WNOHANG) > 0)
+    {
+    }
+}
+
+/**************************************************************************
+ *                     MISE A JOUR DU BINAIRE A CHAUD                     *
+ * ***********************************************************************/
+
+void Server::setExecutable(const std::string& path)
+{
+    char resolved[PATH_MAX];
+    executablePath = realpath(path.c_str(), resolved) ? std::string(resolved) : path;
+}
+
+// Les sockets transmis par l'ancienne instance sont repris au lieu d'être liés à nouveau : aucune connexion n'est refusée
+void Server::adoptInheritedListeners()
+{
+    const char* inherited = getenv(LISTEN_FDS_ENV);
+    if (!inherited)
+    {
+        return;
+    }
+
+    std::istringstream fdsStream(inherited);
+    std::string item;
+    while (getline(fdsStream, item, ','))
+    {
+        int fd = atoi(item.c_str());
+        Listener listener;
+        if (fd <= 2 || !listener.adopt(fd))
+        {
+            LOG_WARNING("Descripteur d'écoute hérité ignoré : " + item);
+            continue;
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        listeners[fd] = listener;
+        LOG_INFO("Socket d'écoute hérité de l'ancienne instance : " + listener.getKey());
+    }
+    unsetenv(LISTEN_FDS_ENV);
+}
+
+// Prévient l'ancienne instance que les sockets sont en écoute ici : elle peut cesser d'accepter et se vider
+void Server::notifyUpgradeReady()
+{
+    const char* readyFd = getenv(UPGRADE_READY_ENV);
+    if (!readyFd)
+    {
+        return;
+    }
+
+    int fd = atoi(readyFd);
+    char ready = 1;
+    if (write(fd, &ready, 1) != 1)
+    {
+        LOG_WARNING("Impossible de signaler l'état prêt à l'ancienne instance.");
+    }
+    close(fd);
+    unsetenv(UPGRADE_READY_ENV);
+}
+
+// SIGUSR2 : relance le binaire (éventuellement remplacé sur disque) en lui transmettant les sockets d'écoute
+void Server::startUpgrade()
+{
+    if (upgradePid != -1)
+    {
+        LOG_WARNING("Mise à jour du binaire déjà en cours, SIGUSR2 ignoré.");
+        return;
+    }
+    if (executablePath.empty())
+    {
+        LOG_ERROR("Chemin de l'exécutable inconnu, mise à jour impossible.");
+        return;
+    }
+
+    int readyPipe[2];
+    if (pipe2(readyPipe, O_CLOEXEC) != 0)
+    {
+        LOG_ERROR("Impossible de créer le pipe de mise à jour.");
+        return;
+    }
+
+    std::ostringstream fds;
+    for (std::map<int, Listener>::iterator it = listeners.begin(); it != listeners.end(); ++it)
+    {
+        fds << (it == listeners.begin() ? "" : ",") << it->first;
+    }
+    std::ostringstream readyFd;
+    readyFd << readyPipe[1];
+
+    LOG_INFO("SIGUSR2 reçu, lancement du nouveau binaire : " + executablePath);
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        LOG_ERROR("fork() a échoué, mise à jour annulée.");
+        close(readyPipe[0]);
+        close(readyPipe[1]);
+        return;
+    }
+
+    if (pid == 0)
+    {
+        // Seuls les sockets d'écoute et l'extrémité d'écriture du pipe survivent à l'exec
+        for (std::map<int, Listener>::iterator it = listeners.begin(); it != listeners.end(); ++it)
+        {
+            fcntl(it->first, F_SETFD, 0);
+        }
+        fcntl(readyPipe[1], F_SETFD, 0);
+        setenv(LISTEN_FDS_ENV, fds.str().c_str(), 1);
+        setenv(UPGRADE_READY_ENV, readyFd.str().c_str(), 1);
+
+        char* argv[] = { const_cast<char*>(executablePath.c_str()), const_cast<char*>(configFilePath.c_str()), NULL };
+        execv(argv[0], argv);
+        _exit(EXIT_FAILURE);
+    }
+
+    close(readyPipe[1]);
+    upgradePipe = readyPipe[0];
+    upgradePid = pid;
+    watchFd(upgradePipe);
+}
+
+// Un octet reçu signifie que la nouvelle instance écoute ; une fin de fichier, qu'elle n'a pas démarré
+void Server::finishUpgrade()
+{
+    char ready = 0;
+    ssize_t count = read(upgradePipe, &ready, 1);
+
+    FD_CLR(upgradePipe, &master_set);
+    close(upgradePipe);
+    upgradePipe = -1;
+
+    if (count == 1)
+    {
+        LOG_INFO("Nouvelle instance prête, arrêt de l'acceptation et vidage des connexions.");
+        beginDrain(true);
+        return;
+    }
+
+    int status;
+    waitpid(upgradePid, &status, WNOHANG);
+    upgradePid = -1;
+    LOG_ERROR("Le nouveau binaire n'a pas démarré, l'instance actuelle continue de servir.");
+}
+
+// Plus d'acceptation : les connexions terminent leur requête en cours sans keep-alive, puis le processus s'arrête.
+// Lors d'une passation, les sockets Unix restent en place pour la nouvelle instance.
+void Server::beginDrain(bool handOff)
+{
+    draining = true;
+    drainDeadline = std::time(0) + getShutdownTimeout();
+
+    for (std::map<int, Listener>::iterator it = listeners.begin(); it != listeners.end(); ++it)
+    {
+        FD_CLR(it->first, &master_set);
+        if (handOff)
+            it->second.detach();
+        else
+            it->second.close();
+    }
+    listeners.clear();
+
+    std::vector<int> idle;
+    for (std::map<int, Connection>::iterator it = connections.begin(); it != connections.end(); ++it)
+    {
+        it->second.listenFd = -1;
+        if (it->second.state == Connection::READING_HEADERS && it->second.buffer.empty() && it->second.output.empty())
+        {
+            idle.push_back(it->first);
+        }
+    }
+    for (size_t i = 0; i < idle.size(); ++i)
+    {
+        closeConnection(idle[i]);
+    }
+}
+
+// Une génération retirée est détruite lorsqu'aucune requête en cours n'utilise plus ses blocs server
+// Un seul bloc server en "log_overflow: block" suffit pour qu'aucun message ne soit perdu
+void Server::configureLogger()
+{
+    bool block = false;
+    const std::vector<ServerConfig>& servers = routingTable->getServers();
+    for (size_t i = 0; i < servers.size(); ++i)
+    {
+        block = block || servers[i].log_overflow_block;
+    }
+    Logger::getInstance().setBlockOnOverflow(block);
+}
+
+void Server::releaseRetiredTables()
+{
+    for (size_t i = retiredTables.size(); i-- > 0; )
+    {
+        bool inUse = false;
+        for (std::map<int, Connection>::const_iterator it = connections.begin(); it != connections.end() && !inUse; ++it)
+        {
+            inUse = it->second.routingTable == retiredTables[i];
+        }
+        if (!inUse)
+        {
+            LOG_INFO("Ancienne génération de configuration libérée.");
+            delete retiredTables[i];
+            retiredTables.erase(retiredTables.begin() + i);
+        }
+    }
+}
+
+// Écrit ce que le socket accepte tout de suite ; le reste est conservé et envoyé quand select() le signale inscriptible
+bool Server::queueOutput(Connection& conn, const std::string& data)
+{
+    bool wasEmpty = conn.output.empty();
+    conn.output.append(data);
+
+    if (wasEmpty)
+    {
+        return flushOutput(conn);
+    }
+    return true;
+}
+
+// Renvoie false si la connexion a été fermée
+bool Server::flushOutput(Connection& conn)
+{
+    while (!conn.output.empty())
     {
-        int fd = *it;
-        FD_SET(fd, &master_set);
-        if (fd > max_fd)
+        ssize_t bytesWritten = send(conn.fd, conn.output.data(), conn.output.size(), MSG_NOSIGNAL);
+        if (bytesWritten < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                FD_SET(conn.fd, &write_set);
+                return true;
+            }
+            LOG_ERROR("Échec de l'envoi des données au client.");
+            closeConnection(conn.fd);
+            return false;
+        }
+        conn.output.erase(0, bytesWritten);
+        conn.bytesOut += bytesWritten;
+        if (!conn.traces.empty())
         {
-            max_fd = fd;
+            advanceTraces(conn, bytesWritten);
         }
     }
 
+    FD_CLR(conn.fd, &write_set);
+    bool orphaned = conn.listenFd == -1 && conn.state == Connection::READING_HEADERS && conn.buffer.empty();
+    if (conn.closeAfterWrite || orphaned)
+    {
+        closeConnection(conn.fd);
+        return false;
+    }
+    if (conn.shutdownAfterWrite)
+    {
+        shutdown(conn.fd, SHUT_WR);
+        conn.shutdownAfterWrite = false;
+    }
+    return true;
+}
+
+void Server::start()
+{
+    fd_set read_fds;
+    fd_set write_fds;
+
     LOG_INFO("Serveur démarré et en attente de connexions sur plusieurs ports...");
 
     std::time_t lastCleanupTime = std::time(0);
@@ -146,102 +633,88 @@ void Server::start()
     while (isRunning)
     {
         read_fds = master_set;
-        if (select(max_fd + 1, &read_fds, NULL, NULL, NULL) < 0)
+        write_fds = write_set;
+
+        // Pendant un vidage, select() se réveille au plus tard à l'échéance
+        struct timeval timeout;
+        struct timeval* timeoutPtr = NULL;
+        if (draining)
+        {
+            std::time_t remaining = drainDeadline - Clock::getInstance().now();
+            timeout.tv_sec = remaining > 0 ? remaining : 0;
+            timeout.tv_usec = 0;
+            timeoutPtr = &timeout;
+        }
+        else if (accessLog.hasPending())
+        {
+            timeout.tv_sec = ACCESS_LOG_FLUSH_INTERVAL;
+            timeout.tv_usec = 0;
+            timeoutPtr = &timeout;
+        }
+
+        if (select(max_fd + 1, &read_fds, &write_fds, NULL, timeoutPtr) < 0)
         {
+            if (errno == EINTR)
+            {
+                continue;
+            }
             LOG_ERROR("Erreur lors de l'exécution de select");
             exit(EXIT_FAILURE);
         }
+        Clock::getInstance().update();
+        struct timeval iterationStart = Clock::getInstance().precise();
+        Metrics::getInstance().increment(Metrics::LOOP_ITERATIONS);
 
         for (int i = 0; i <= max_fd; i++)
         {
-            if (FD_ISSET(i, &read_fds))
+            if (FD_ISSET(i, &write_fds) && connections.find(i) != connections.end())
             {
-                if (std::find(server_fds.begin(), server_fds.end(), i) != server_fds.end())
+                if (!flushOutput(connections[i]))
+                {
+                    continue;
+                }
+            }
+            if (FD_ISSET(i, &read_fds) && FD_ISSET(i, &master_set))
+            {
+                if (i == signalPipe[0])
+                {
+                    handleSignals();
+                }
+                else if (i == upgradePipe)
+                {
+                    finishUpgrade();
+                }
+                else if (listeners.find(i) != listeners.end())
                 {
-                    sockaddr_in client_addr;
-                    socklen_t client_len = sizeof(client_addr);
-                    int client_fd = accept(i, (sockaddr*)&client_addr, &client_len);
-                    if (client_fd < 0)
-                    {
-                        LOG_ERROR("Erreur lors de l'acceptation d'une nouvelle connexion");
-                    }
-                    else
-                    {
-                        FD_SET(client_fd, &master_set);
-                        if (client_fd > max_fd)
-                        {
-                            max_fd = client_fd;
-                        }
-                        std::ostringstream oss;
-                        oss << "Nouvelle connexion depuis " << inet_ntoa(client_addr.sin_addr);
-                        LOG_INFO(oss.str());
-                    }
+                    acceptConnection(i);
                 }
                 else
                 {
-                    char buffer[1024] = {0};
-                    ssize_t bytes_read = read(i, buffer, sizeof(buffer) - 1);
-                    if (bytes_read <= 0)
-                    {
-                        close(i);
-                        FD_CLR(i, &master_set);
-                    }
-                    else
-                    {
-                        // Création de l'objet Cookies et extraction des cookies de la requête
-                        Cookies cookies;
-                        std::string requestStr(buffer, bytes_read);
-
-                        // Log avant extraction
-                        LOG_INFO("Extracting cookies from request: " + requestStr);
-
-                        cookies.extractCookiesFromRequest(requestStr);
-
-                        // Tentative de récupération du sessionId
-                        std::string sessionId = cookies.getValue("sessionId");
-
-                        // Log après tentative de récupération
-                        LOG_INFO("Retrieved sessionId from cookies: " + sessionId);
-
-                        // Validation et gestion de la session
-                        if (!sessionId.empty() && sessionManager.validateSession(sessionId))
-                        {
-                            LOG_INFO("Session valid. Updating last activity for sessionId: " + sessionId);
-                            sessionManager.updateLastActivity(sessionId);
-                        }
-                        else
-                        {
-                            LOG_INFO("Session invalid or not found. Creating new session.");
-                            sessionId = sessionManager.createSession();
-                            int cookieMaxAge = 3600;
-                            cookies.setValue("sessionId", sessionId, false, "/", cookieMaxAge);
-
-                            // Log après la création d'une nouvelle session
-                            std::ostringstream oss;
-                            oss << "New session created with sessionId: " << sessionId << ". Max Age: " << cookieMaxAge;
-                            LOG_INFO(oss.str());
-
-                        }
-
-
-                        HttpRequest httpRequest = requestHandler.parseRequest(requestStr);
-                        HttpResponse httpResponse = requestHandler.handleRequest(httpRequest);
-
-                        httpResponse.headers["Set-Cookie"] = cookies.toString();
-
-                        std::string responseText = Response::buildHttpResponse(httpResponse);
-                        safeWrite(i, responseText);
-
-                        std::string connectionHeader = httpRequest.getHeader("Connection");
-                        if (connectionHeader != "keep-alive")
-                        {
-                            close(i);
-                            FD_CLR(i, &master_set);
-                        }
-                    }
+                    readFromClient(i);
                 }
             }
         }
+
+        if (!retiredTables.empty())
+        {
+            releaseRetiredTables();
+        }
+        rateLimiter.decay();
+        accessLog.flush(false);
+        Metrics::getInstance().observe(Metrics::LOOP_DURATION, Metrics::elapsedMicros(iterationStart));
+        if (draining && connections.empty())
+        {
+            LOG_INFO("Toutes les connexions sont terminées, arrêt du serveur.");
+            break;
+        }
+        if (draining && Clock::getInstance().now() >= drainDeadline)
+        {
+            std::ostringstream oss;
+            oss << "Délai de vidage écoulé, fermeture forcée de " << connections.size() << " connexion(s).";
+            LOG_WARNING(oss.str());
+            closeAllConnections();
+            break;
+        }
     }
     std::time_t now = std::time(0);
     if (now - lastCleanupTime > cleanupInterval)
@@ -251,3 +724,854 @@ void Server::start()
     }
 }
 
+/**************************************************************************
+ *                       GESTION DES CONNEXIONS                           *
+ * ***********************************************************************/
+
+static const char TOO_MANY_CONNECTIONS[] =
+    "HTTP/1.1 429 Too Many Requests\r\nContent-Length: 0\r\nRetry-After: 1\r\nConnection: close\r\n\r\n";
+
+// Vide la file d'attente du socket d'écoute jusqu'à EAGAIN, dans la limite de accept_batch connexions par réveil
+void Server::acceptConnection(int listen_fd)
+{
+    const Listener& listener = listeners[listen_fd];
+
+    for (int accepted = 0; accepted < listener.getAcceptBatch(); ++accepted)
+    {
+        sockaddr_storage client_addr;
+        memset(&client_addr, 0, sizeof(client_addr));
+        socklen_t client_len = sizeof(client_addr);
+        int client_fd = accept4(listen_fd, reinterpret_cast<sockaddr*>(&client_addr), &client_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                LOG_ERROR("Erreur lors de l'acceptation d'une nouvelle connexion");
+            }
+            return;
+        }
+
+        // select() ne sait pas surveiller un descripteur au-delà de FD_SETSIZE
+        if (client_fd >= FD_SETSIZE)
+        {
+            LOG_ERROR("Trop de descripteurs ouverts, connexion refusée.");
+            close(client_fd);
+            continue;
+        }
+
+        // Réseau refusé par allowed_ips/denied_ips de tous les blocs de l'écoute : fermeture sans rien lire ni journaliser
+        if (!routingTable->isAllowed(listen_fd, reinterpret_cast<sockaddr*>(&client_addr)))
+        {
+            Metrics::getInstance().increment(Metrics::CONNECTIONS_REJECTED);
+            close(client_fd);
+            continue;
+        }
+
+        // Refus immédiat, sans lire la requête, au-delà de max_connections_per_ip du serveur par défaut du port
+        std::string remoteAddress = Listener::formatHost(reinterpret_cast<sockaddr*>(&client_addr), client_len);
+        const ServerConfig* defaultServer = routingTable->resolve(listen_fd, "");
+        if (!rateLimiter.acquireConnection(remoteAddress, defaultServer ? defaultServer->max_connections_per_ip : 0))
+        {
+            LOG_WARNING("Trop de connexions simultanées depuis " + remoteAddress + ", connexion refusée.");
+            Metrics::getInstance().increment(Metrics::CONNECTIONS_REJECTED);
+            send(client_fd, TOO_MANY_CONNECTIONS, sizeof(TOO_MANY_CONNECTIONS) - 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+            close(client_fd);
+            continue;
+        }
+
+        if (listener.getNoDelay())
+        {
+            int opt = 1;
+            setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        }
+
+        FD_SET(client_fd, &master_set);
+        if (client_fd > max_fd)
+        {
+            max_fd = client_fd;
+        }
+        connections[client_fd].fd = client_fd;
+        connections[client_fd].listenFd = listen_fd;
+        connections[client_fd].remoteAddress = remoteAddress;
+        Metrics::getInstance().increment(Metrics::CONNECTIONS_ACCEPTED);
+
+        LOG_INFO("Nouvelle connexion depuis " + connections[client_fd].remoteAddress + " sur " + listener.getKey());
+    }
+}
+
+void Server::readFromClient(int fd)
+{
+    Connection& current = connections[fd];
+    if (current.state == Connection::DISCARDING)
+    {
+        discardInput(current);
+        return;
+    }
+
+    if (current.rawUpload && current.rawUpload->canSplice() && current.buffer.empty() && !current.chunked
+        && current.state == Connection::READING_BODY && current.bodyReceived < current.contentLength)
+    {
+        ssize_t moved = current.rawUpload->spliceFrom(fd, current.contentLength - current.bodyReceived);
+        if (moved > 0)
+        {
+            current.bodyReceived += moved;
+            current.bytesIn += moved;
+            processConnection(current);
+            return;
+        }
+        if (moved == 0)
+        {
+            closeConnection(fd);
+            return;
+        }
+        if (errno == EAGAIN)
+        {
+            return;
+        }
+        if (current.rawUpload->hasFailed())
+        {
+            HttpResponse httpResponse = requestHandler.generateErrorResponse(500, "Internal Server Error");
+            sendResponse(current, httpResponse, false);
+            return;
+        }
+        current.rawUpload->disableSplice();
+    }
+
+    char buffer[READ_BUFFER_SIZE];
+    ssize_t bytes_read = read(fd, buffer, sizeof(buffer));
+    if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+        return;
+    }
+    if (bytes_read <= 0)
+    {
+        closeConnection(fd);
+        return;
+    }
+
+    Connection& conn = connections[fd];
+    if (conn.state == Connection::READING_HEADERS && conn.buffer.empty())
+    {
+        conn.requestStart = Clock::getInstance().precise();
+        conn.trace.reset();
+        conn.trace.marks[RequestTrace::RECEIVED] = Clock::monotonic();
+    }
+    conn.bytesIn += bytes_read;
+    conn.buffer.append(buffer, bytes_read);
+    processConnection(conn);
+}
+
+// Fait avancer la machine à états avec les octets en attente ; renvoie false si la connexion a été fermée
+bool Server::processConnection(Connection& conn)
+{
+    while (true)
+    {
+        if (conn.state == Connection::DISCARDING)
+        {
+            conn.buffer.clear();
+            return true;
+        }
+
+        if (conn.state == Connection::READING_HEADERS)
+        {
+            std::string::size_type headerEnd = conn.buffer.find("\r\n\r\n");
+            if (headerEnd == std::string::npos)
+            {
+                if (conn.buffer.size() > MAX_HEADER_SIZE)
+                {
+                    LOG_ERROR("En-têtes de requête trop volumineux, fermeture de la connexion.");
+                    HttpResponse httpResponse = requestHandler.generateErrorResponse(400, "Bad Request");
+                    return sendResponse(conn, httpResponse, false);
+                }
+                return true;
+            }
+
+            conn.headerText = conn.buffer.substr(0, headerEnd + 4);
+            conn.buffer.erase(0, headerEnd + 4);
+            int status = beginRequest(conn);
+            if (status < 0)
+            {
+                return false;
+            }
+            if (status == 0)
+            {
+                continue;
+            }
+        }
+
+        int status = conn.chunked ? readChunkedBody(conn) : readFixedBody(conn);
+        if (status < 0)
+        {
+            return false;
+        }
+        if (status == 0 || conn.state == Connection::DISCARDING)
+        {
+            return true;
+        }
+        if (!completeRequest(conn))
+        {
+            return false;
+        }
+        if (conn.buffer.empty())
+        {
+            return true;
+        }
+    }
+}
+
+// Analyse les en-têtes et applique les limites avant de lire le moindre octet du corps ;
+// renvoie -1 si la connexion a été fermée, 0 si la requête a été rejetée, 1 pour passer à la lecture du corps
+int Server::beginRequest(Connection& conn)
+{
+    conn.request = requestHandler.parseRequest(conn.headerText);
+    conn.trace.marks[RequestTrace::PARSED] = Clock::monotonic();
+    conn.state = Connection::READING_BODY;
+    conn.bodyReceived = 0;
+    conn.contentLength = 0;
+
+    conn.routingTable = routingTable;
+    conn.serverConfig = routingTable->resolve(conn.listenFd, conn.request.getHeader("Host"));
+    if (!conn.serverConfig)
+    {
+        return rejectRequest(conn, 400, "Bad Request") ? 0 : -1;
+    }
+    if (!routingTable->isAllowed(conn.serverConfig, conn.remoteAddress))
+    {
+        LOG_WARNING("Accès refusé à " + conn.remoteAddress + " pour l'URI: " + conn.request.uri);
+        Metrics::getInstance().increment(Metrics::REQUESTS_DENIED);
+        return rejectRequest(conn, 403, "Forbidden") ? 0 : -1;
+    }
+    conn.serverConfig = routingTable->resolveLocation(conn.serverConfig, conn.request.uri);
+    conn.trace.marks[RequestTrace::ROUTED] = Clock::monotonic();
+    if (!rateLimiter.consumeRequest(conn.remoteAddress, conn.serverConfig->rate_limit, conn.serverConfig->rate_limit_burst))
+    {
+        LOG_WARNING("Limite de requêtes dépassée pour " + conn.remoteAddress + " sur l'URI: " + conn.request.uri);
+        Metrics::getInstance().increment(Metrics::REQUESTS_RATE_LIMITED);
+        HttpResponse httpResponse = requestHandler.generateErrorResponse(429, "Too Many Requests");
+        httpResponse.headers["Retry-After"] = "1";
+        return rejectRequest(conn, httpResponse) ? 0 : -1;
+    }
+    conn.maxBodySize = requestHandler.getMaxBodySize(*conn.serverConfig);
+
+    std::string transferEncoding = conn.request.getHeader("Transfer-Encoding");
+    std::string contentLength = conn.request.getHeader("Content-Length");
+    conn.chunked = transferEncoding.find("chunked") != std::string::npos;
+
+    if (conn.chunked)
+    {
+        conn.chunkState = Connection::CHUNK_SIZE;
+        conn.chunkRemaining = 0;
+    }
+    else if (!contentLength.empty())
+    {
+        char* end = NULL;
+        conn.contentLength = std::strtoul(contentLength.c_str(), &end, 10);
+        if (*end != '\0' || contentLength[0] == '-')
+        {
+            LOG_ERROR("Content-Length invalide : " + contentLength);
+            return rejectRequest(conn, 400, "Bad Request") ? 0 : -1;
+        }
+    }
+
+    if (conn.maxBodySize > 0 && conn.contentLength > conn.maxBodySize)
+    {
+        std::ostringstream oss;
+        oss << "Corps annoncé de " << conn.contentLength << " octets supérieur à la limite de " << conn.maxBodySize << " pour l'URI: " << conn.request.uri;
+        LOG_WARNING(oss.str());
+        return rejectRequest(conn, 413, "Payload Too Large") ? 0 : -1;
+    }
+
+    if (!conn.request.getHeader("Expect").empty())
+    {
+        int status = handleExpectation(conn);
+        if (status <= 0)
+        {
+            return status;
+        }
+    }
+
+    if (conn.contentLength > 0 || conn.chunked)
+    {
+        conn.multipart = requestHandler.createUploadParser(conn.request, *conn.serverConfig);
+        if (!conn.multipart)
+        {
+            conn.rawUpload = requestHandler.createRawUpload(conn.request, *conn.serverConfig);
+        }
+    }
+    return 1;
+}
+
+// Renvoie -1 si la connexion a été fermée, 0 s'il manque des octets, 1 quand le corps est complet
+int Server::readFixedBody(Connection& conn)
+{
+    // Seuls les octets appartenant à la requête courante sont consommés, la suite reste pour la requête suivante
+    size_t take = std::min(conn.contentLength - conn.bodyReceived, conn.buffer.size());
+    if (take > 0)
+    {
+        if (!consumeBody(conn, conn.buffer.data(), take))
+        {
+            return -1;
+        }
+        conn.buffer.erase(0, take);
+    }
+    return conn.bodyReceived < conn.contentLength ? 0 : 1;
+}
+
+// Décode le corps chunked au fil de l'eau en contrôlant le total cumulé ; mêmes valeurs de retour que readFixedBody
+int Server::readChunkedBody(Connection& conn)
+{
+    while (true)
+    {
+        if (conn.chunkState == Connection::CHUNK_DATA)
+        {
+            size_t take = std::min(conn.chunkRemaining, conn.buffer.size());
+            if (take > 0)
+            {
+                if (!consumeBody(conn, conn.buffer.data(), take))
+                {
+                    return -1;
+                }
+                conn.buffer.erase(0, take);
+                conn.chunkRemaining -= take;
+            }
+            if (conn.chunkRemaining > 0)
+            {
+                return 0;
+            }
+            conn.chunkState = Connection::CHUNK_DATA_END;
+            continue;
+        }
+
+        std::string::size_type lineEnd = conn.buffer.find("\r\n");
+        if (lineEnd == std::string::npos)
+        {
+            if (conn.buffer.size() > MAX_HEADER_SIZE && !rejectRequest(conn, 400, "Bad Request"))
+            {
+                return -1;
+            }
+            return 0;
+        }
+        std::string line = conn.buffer.substr(0, lineEnd);
+        conn.buffer.erase(0, lineEnd + 2);
+
+        if (conn.chunkState == Connection::CHUNK_DATA_END)
+        {
+            if (!line.empty())
+            {
+                LOG_ERROR("Fin de chunk mal formée pour l'URI: " + conn.request.uri);
+                return rejectRequest(conn, 400, "Bad Request") ? 0 : -1;
+            }
+            conn.chunkState = Connection::CHUNK_SIZE;
+        }
+        else if (conn.chunkState == Connection::CHUNK_SIZE)
+        {
+            char* end = NULL;
+            size_t chunkSize = std::strtoul(line.c_str(), &end, 16);
+            if (end == line.c_str() || (*end != '\0' && *end != ';' && *end != ' '))
+            {
+                LOG_ERROR("Taille de chunk invalide : " + line);
+                return rejectRequest(conn, 400, "Bad Request") ? 0 : -1;
+            }
+            if (conn.maxBodySize > 0 && (chunkSize > conn.maxBodySize || conn.bodyReceived + chunkSize > conn.maxBodySize))
+            {
+                LOG_WARNING("Corps chunked supérieur à la limite autorisée pour l'URI: " + conn.request.uri);
+                return rejectRequest(conn, 413, "Payload Too Large") ? 0 : -1;
+            }
+            conn.chunkRemaining = chunkSize;
+            conn.chunkState = chunkSize == 0 ? Connection::CHUNK_TRAILER : Connection::CHUNK_DATA;
+        }
+        else if (line.empty())
+        {
+            // Le corps décodé est transmis tel quel : on expose sa taille réelle (utile pour CONTENT_LENGTH en CGI)
+            std::ostringstream oss;
+            oss << conn.bodyReceived;
+            conn.request.headers.erase("Transfer-Encoding");
+            conn.request.headers["Content-Length"] = oss.str();
+            return 1;
+        }
+    }
+}
+
+// Le client attend notre accord avant d'envoyer le corps : on valide tout ce qui peut l'être sur les seuls en-têtes ;
+// mêmes valeurs de retour que beginRequest
+int Server::handleExpectation(Connection& conn)
+{
+    std::string expectation = conn.request.getHeader("Expect");
+    for (size_t i = 0; i < expectation.size(); ++i)
+    {
+        expectation[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(expectation[i])));
+    }
+
+    if (expectation != "100-continue")
+    {
+        LOG_WARNING("Attente non prise en charge : " + expectation);
+        return rejectRequest(conn, 417, "Expectation Failed") ? 0 : -1;
+    }
+
+    HttpResponse errorResponse;
+    if (!requestHandler.validateHeaders(conn.request, *conn.serverConfig, errorResponse))
+    {
+        LOG_INFO("Requête refusée avant réception du corps pour l'URI: " + conn.request.uri);
+        return rejectRequest(conn, errorResponse) ? 0 : -1;
+    }
+
+    // Inutile de relancer le client s'il n'y a pas de corps ou s'il a déjà commencé à l'envoyer
+    if ((conn.contentLength > 0 || conn.chunked) && conn.buffer.empty() && conn.request.httpVersion == "HTTP/1.1")
+    {
+        LOG_INFO("Envoi de 100 Continue pour l'URI: " + conn.request.uri);
+        if (!queueOutput(conn, "HTTP/1.1 100 Continue\r\n\r\n"))
+        {
+            return -1;
+        }
+    }
+    return 1;
+}
+
+// Répond immédiatement puis ignore le reste de l'envoi sans le stocker, jusqu'à fermeture par le client ou DISCARD_LIMIT octets ;
+// renvoie false si la connexion a été fermée (conn n'est alors plus utilisable)
+bool Server::rejectRequest(Connection& conn, int statusCode, const std::string& statusMessage)
+{
+    HttpResponse httpResponse = requestHandler.generateErrorResponse(statusCode, statusMessage);
+    return rejectRequest(conn, httpResponse);
+}
+
+bool Server::rejectRequest(Connection& conn, HttpResponse& httpResponse)
+{
+    httpResponse.headers["Connection"] = "close";
+
+    // La fermeture en écriture attend que la réponse soit entièrement partie
+    conn.shutdownAfterWrite = true;
+    std::string rawResponse = Response::buildHttpResponse(httpResponse);
+    logAccess(conn, httpResponse, rawResponse.size());
+    if (!queueOutput(conn, rawResponse))
+    {
+        return false;
+    }
+
+    delete conn.multipart;
+    conn.multipart = NULL;
+    delete conn.rawUpload;
+    conn.rawUpload = NULL;
+    conn.buffer.clear();
+    conn.discarded = 0;
+    conn.state = Connection::DISCARDING;
+    return true;
+}
+
+void Server::discardInput(Connection& conn)
+{
+    char buffer[READ_BUFFER_SIZE];
+    ssize_t bytes_read = read(conn.fd, buffer, sizeof(buffer));
+
+    if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+        return;
+    }
+    if (bytes_read > 0)
+    {
+        conn.discarded += bytes_read;
+    }
+    if (bytes_read <= 0 || conn.discarded >= DISCARD_LIMIT)
+    {
+        closeConnection(conn.fd);
+    }
+}
+
+bool Server::consumeBody(Connection& conn, const char* data, size_t length)
+{
+    conn.bodyReceived += length;
+
+    if (conn.rawUpload)
+    {
+        if (!conn.rawUpload->write(data, length))
+        {
+            HttpResponse httpResponse = requestHandler.generateErrorResponse(500, "Internal Server Error");
+            sendResponse(conn, httpResponse, false);
+            return false;
+        }
+        return true;
+    }
+
+    if (!conn.multipart)
+    {
+        conn.request.body.append(data, length);
+        return true;
+    }
+
+    if (!conn.multipart->feed(data, length))
+    {
+        LOG_ERROR("Corps multipart invalide pour l'URI: " + conn.request.uri);
+        HttpResponse httpResponse = requestHandler.generateErrorResponse(400, "Bad Request");
+        sendResponse(conn, httpResponse, false);
+        return false;
+    }
+    return true;
+}
+
+bool Server::completeRequest(Connection& conn)
+{
+    conn.trace.marks[RequestTrace::BODY_RECEIVED] = Clock::monotonic();
+    if (conn.multipart)
+    {
+        if (!conn.multipart->isComplete())
+        {
+            LOG_ERROR("Corps multipart incomplet pour l'URI: " + conn.request.uri);
+            HttpResponse httpResponse = requestHandler.generateErrorResponse(400, "Bad Request");
+            return sendResponse(conn, httpResponse, false);
+        }
+        conn.request.uploadedFiles = conn.multipart->getFiles();
+        delete conn.multipart;
+        conn.multipart = NULL;
+    }
+
+    if (conn.rawUpload)
+    {
+        if (!conn.rawUpload->finish())
+        {
+            HttpResponse httpResponse = requestHandler.generateErrorResponse(500, "Internal Server Error");
+            return sendResponse(conn, httpResponse, false);
+        }
+        conn.request.uploadedFiles.push_back(conn.rawUpload->getFileName());
+        delete conn.rawUpload;
+        conn.rawUpload = NULL;
+    }
+
+    // Locations internes (métriques, état des connexions) : ni cookies ni session
+    if (conn.serverConfig->metrics || conn.serverConfig->status)
+    {
+        HttpResponse httpResponse = buildInternalResponse(conn);
+        return sendResponse(conn, httpResponse, conn.request.getHeader("Connection") == "keep-alive");
+    }
+
+    // Création de l'objet Cookies et extraction des cookies de la requête
+    Cookies cookies;
+    const std::string& requestStr = conn.headerText;
+
+    // Log avant extraction
+    LOG_INFO("Extracting cookies from request: " + requestStr);
+
+    cookies.extractCookiesFromRequest(requestStr);
+
+    // Tentative de récupération du sessionId
+    std::string sessionId = cookies.getValue("sessionId");
+
+    // Log après tentative de récupération
+    LOG_INFO("Retrieved sessionId from cookies: " + sessionId);
+
+    // Validation et gestion de la session
+    if (!sessionId.empty() && sessionManager.validateSession(sessionId))
+    {
+        LOG_INFO("Session valid. Updating last activity for sessionId: " + sessionId);
+        sessionManager.updateLastActivity(sessionId);
+    }
+    else
+    {
+        LOG_INFO("Session invalid or not found. Creating new session.");
+        sessionId = sessionManager.createSession();
+        int cookieMaxAge = 3600;
+        cookies.setValue("sessionId", sessionId, false, "/", cookieMaxAge);
+
+        // Log après la création d'une nouvelle session
+        LOG_INFO_STREAM("New session created with sessionId: " << sessionId << ". Max Age: " << cookieMaxAge);
+
+    }
+
+    struct timeval handlerStart;
+    gettimeofday(&handlerStart, NULL);
+    conn.trace.marks[RequestTrace::HANDLER_START] = Clock::monotonic();
+    requestHandler.setTrace(&conn.trace);
+    HttpResponse httpResponse = requestHandler.handleRequest(conn.request, *conn.serverConfig);
+    requestHandler.setTrace(NULL);
+    conn.trace.marks[RequestTrace::HANDLER_END] = Clock::monotonic();
+    unsigned long handlerMicros = Metrics::elapsedMicros(handlerStart);
+    Metrics::getInstance().observe(Metrics::HANDLER_DURATION, handlerMicros);
+    if (requestHandler.isCgiRequest(conn.request, *conn.serverConfig))
+    {
+        conn.upstreamTime = handlerMicros / 1e6;
+    }
+
+    httpResponse.headers["Set-Cookie"] = cookies.toString();
+
+    std::string connectionHeader = conn.request.getHeader("Connection");
+    return sendResponse(conn, httpResponse, connectionHeader == "keep-alive");
+}
+
+// Envoie la réponse puis prépare la connexion pour la requête suivante ou la ferme ; renvoie false si elle a été fermée
+bool Server::sendResponse(Connection& conn, HttpResponse& httpResponse, bool keepAlive)
+{
+    // Une connexion dont le socket d'écoute a disparu au rechargement ne sert pas de requête suivante
+    keepAlive = keepAlive && conn.listenFd != -1;
+
+    // Sans keep-alive on cesse de lire : la connexion sera fermée une fois la réponse envoyée
+    if (!keepAlive)
+    {
+        conn.closeAfterWrite = true;
+        FD_CLR(conn.fd, &master_set);
+    }
+    std::string rawResponse = Response::buildHttpResponse(httpResponse);
+    logAccess(conn, httpResponse, rawResponse.size());
+    if (!queueOutput(conn, rawResponse) || !keepAlive)
+    {
+        return false;
+    }
+
+    resetConnection(conn);
+    return true;
+}
+
+// Durée mesurée du premier octet de la requête à la mise en file de la réponse
+void Server::logAccess(Connection& conn, const HttpResponse& httpResponse, size_t bytesSent)
+{
+    ++conn.requests;
+
+    Metrics& metrics = Metrics::getInstance();
+    metrics.countResponse(httpResponse.statusCode);
+    metrics.increment(Metrics::RESPONSE_BYTES, bytesSent);
+    unsigned long requestMicros = Metrics::elapsedMicros(conn.requestStart);
+    metrics.observe(Metrics::REQUEST_DURATION, requestMicros);
+
+    const ServerConfig* serverConfig = conn.serverConfig;
+    if (!serverConfig && conn.listenFd != -1)
+    {
+        serverConfig = routingTable->resolve(conn.listenFd, "");
+    }
+    if (serverConfig && (serverConfig->trace != TRACE_OFF || !serverConfig->slow_log.empty()))
+    {
+        queueTrace(conn, *serverConfig, httpResponse, bytesSent);
+    }
+    if (!serverConfig || serverConfig->access_log.empty() || serverConfig->access_log == "off")
+    {
+        return;
+    }
+
+    AccessLogEntry entry;
+    entry.remoteAddress = conn.remoteAddress;
+    entry.vhost = serverConfig->server_names.empty() ? "" : serverConfig->server_names[0];
+    entry.method = conn.request.method;
+    entry.uri = conn.request.uri;
+    entry.httpVersion = conn.request.httpVersion;
+    entry.referer = conn.request.getHeader("Referer");
+    entry.userAgent = conn.request.getHeader("User-Agent");
+    entry.status = httpResponse.statusCode;
+    entry.bytesSent = bytesSent;
+    entry.requestTime = requestMicros / 1e6;
+    entry.upstreamTime = conn.upstreamTime;
+    entry.requests = conn.requests;
+    accessLog.write(*serverConfig, entry);
+}
+
+HttpResponse Server::buildInternalResponse(const Connection& conn)
+{
+    if (conn.request.method != "GET")
+    {
+        HttpResponse httpResponse = requestHandler.generateErrorResponse(405, "Method Not Allowed");
+        httpResponse.headers["Allow"] = "GET";
+        return httpResponse;
+    }
+
+    HttpResponse httpResponse;
+    httpResponse.httpVersion = "HTTP/1.1";
+    httpResponse.statusCode = 200;
+    httpResponse.statusMessage = "OK";
+    httpResponse.headers["Cache-Control"] = "no-store";
+    if (conn.serverConfig->metrics)
+    {
+        httpResponse.body = renderMetrics();
+        httpResponse.headers["Content-Type"] = "text/plain; version=0.0.4; charset=utf-8";
+    }
+    else
+    {
+        httpResponse.body = renderStatus(conn);
+        httpResponse.headers["Content-Type"] = "text/plain; charset=utf-8";
+    }
+    return httpResponse;
+}
+
+// Appelé avant la mise en file de la réponse : tout ce qui attend déjà dans conn.output partira avant elle
+void Server::queueTrace(Connection& conn, const ServerConfig& serverConfig, const HttpResponse& httpResponse, size_t bytesSent)
+{
+    TraceRecord record;
+    record.trace = conn.trace;
+    record.mode = serverConfig.trace;
+    record.path = (serverConfig.trace == TRACE_CHROME) ? serverConfig.trace_file : serverConfig.access_log;
+    record.json = serverConfig.access_log_json;
+    record.fd = conn.fd;
+    record.remoteAddress = conn.remoteAddress;
+    record.method = conn.request.method;
+    record.uri = conn.request.uri;
+    record.httpVersion = conn.request.httpVersion;
+    record.status = httpResponse.statusCode;
+    record.firstByteOffset = conn.output.size();
+    record.lastByteOffset = conn.output.size() + bytesSent;
+    if (!serverConfig.slow_log.empty())
+    {
+        record.vhost = serverConfig.server_names.empty() ? "" : serverConfig.server_names[0];
+        record.slowLog = serverConfig.slow_log;
+        record.slowThreshold = serverConfig.slow_log_threshold * 1000L;
+        record.headersInRequest = true;
+    }
+    conn.traces.push_back(record);
+}
+
+// Une trace est émise dès que le dernier octet de sa réponse est passé au noyau ; le seuil du journal des requêtes lentes
+// porte sur la même durée, de la réception du premier octet à l'envoi du dernier
+void Server::advanceTraces(Connection& conn, size_t bytesWritten)
+{
+    long now = Clock::monotonic();
+    std::vector<TraceRecord>::iterator it = conn.traces.begin();
+    while (it != conn.traces.end())
+    {
+        if (it->firstByteOffset < bytesWritten && it->trace.marks[RequestTrace::FIRST_BYTE] < 0)
+        {
+            it->trace.marks[RequestTrace::FIRST_BYTE] = now;
+        }
+        it->firstByteOffset -= std::min(it->firstByteOffset, bytesWritten);
+        if (it->lastByteOffset > bytesWritten)
+        {
+            it->lastByteOffset -= bytesWritten;
+            ++it;
+            continue;
+        }
+        it->trace.marks[RequestTrace::LAST_BYTE] = now;
+        if (it->mode != TRACE_OFF)
+        {
+            accessLog.writeTrace(*it);
+        }
+        if (!it->slowLog.empty() && now - it->trace.marks[RequestTrace::RECEIVED] >= it->slowThreshold)
+        {
+            if (it->headersInRequest)
+            {
+                it->headers = conn.request.headers;
+            }
+            Metrics::getInstance().increment(Metrics::SLOW_REQUESTS);
+            accessLog.writeSlow(*it);
+        }
+        it = conn.traces.erase(it);
+    }
+}
+
+// Les jauges sont relevées au moment du rendu plutôt qu'à chaque changement
+std::string Server::renderMetrics()
+{
+    Metrics& metrics = Metrics::getInstance();
+    metrics.setGauge(Metrics::ACTIVE_CONNECTIONS, connections.size());
+    metrics.setGauge(Metrics::LISTENERS, listeners.size());
+    metrics.setGauge(Metrics::RATE_LIMITER_ENTRIES, rateLimiter.size());
+    return metrics.render();
+}
+
+// Résumé à la manière de stub_status suivi d'une ligne par connexion ouverte
+std::string Server::renderStatus(const Connection& current) const
+{
+    const Metrics& metrics = Metrics::getInstance();
+    std::map<std::string, int> stateCounts;
+    std::string table;
+    char line[512];
+    std::time_t now = Clock::getInstance().now();
+
+    std::sprintf(line, "%-5s %-10s %-40s %-24s %10s %10s %6s %5s %s\n",
+        "fd", "state", "client", "vhost", "in", "out", "age", "reqs", "request");
+    table += line;
+    for (std::map<int, Connection>::const_iterator it = connections.begin(); it != connections.end(); ++it)
+    {
+        const Connection& conn = it->second;
+        const char* state = (&conn == &current) ? "writing" : describeState(conn);
+        ++stateCounts[state];
+
+        std::string vhost = "-";
+        if (conn.serverConfig && !conn.serverConfig->server_names.empty())
+        {
+            vhost = conn.serverConfig->server_names[0];
+        }
+        std::string request = "-";
+        if (conn.state != Connection::READING_HEADERS)
+        {
+            request = conn.request.method + " " + conn.request.uri.substr(0, 200);
+        }
+
+        std::sprintf(line, "%-5d %-10s %-40s %-24s %10lu %10lu %6ld %5d ",
+            conn.fd, state, conn.remoteAddress.substr(0, 40).c_str(), vhost.substr(0, 24).c_str(),
+            conn.bytesIn, conn.bytesOut, static_cast<long>(now - conn.acceptedAt), conn.requests);
+        table += line;
+        table += request;
+        table += '\n';
+    }
+
+    std::string output;
+    std::sprintf(line, "Active connections: %lu\nserver accepts handled requests\n %lu %lu %lu\n"
+        "Reading: %d Writing: %d Waiting: %d Discarding: %d\n\n",
+        static_cast<unsigned long>(connections.size()),
+        metrics.getCounter(Metrics::CONNECTIONS_ACCEPTED) + metrics.getCounter(Metrics::CONNECTIONS_REJECTED),
+        metrics.getCounter(Metrics::CONNECTIONS_ACCEPTED), metrics.getResponseCount(),
+        stateCounts["reading"], stateCounts["writing"], stateCounts["idle"], stateCounts["discarding"]);
+    output += line;
+    output += table;
+    return output;
+}
+
+// Le CGI s'exécute de manière bloquante dans completeRequest : aucune connexion n'est jamais vue en attente d'un script
+const char* Server::describeState(const Connection& conn)
+{
+    if (!conn.output.empty())
+    {
+        return "writing";
+    }
+    if (conn.state == Connection::DISCARDING)
+    {
+        return "discarding";
+    }
+    if (conn.state == Connection::READING_HEADERS && conn.buffer.empty())
+    {
+        return "idle";
+    }
+    return "reading";
+}
+
+void Server::resetConnection(Connection& conn)
+{
+    delete conn.multipart;
+    conn.multipart = NULL;
+    delete conn.rawUpload;
+    conn.rawUpload = NULL;
+    conn.state = Connection::READING_HEADERS;
+    conn.routingTable = NULL;
+    conn.serverConfig = NULL;
+    conn.headerText.clear();
+    // Réponse encore en cours d'envoi : ses en-têtes lui sont cédés sans copie avant l'effacement de la requête
+    if (!conn.traces.empty() && conn.traces.back().headersInRequest)
+    {
+        conn.traces.back().headers.swap(conn.request.headers);
+        conn.traces.back().headersInRequest = false;
+    }
+    conn.request = HttpRequest();
+    conn.contentLength = 0;
+    conn.bodyReceived = 0;
+    conn.chunked = false;
+    conn.chunkRemaining = 0;
+    conn.upstreamTime = -1;
+    // Une requête déjà tamponnée (pipelining) commence maintenant ; sinon à la réception de son premier octet
+    conn.requestStart = Clock::getInstance().precise();
+    conn.trace.reset();
+    conn.trace.marks[RequestTrace::RECEIVED] = Clock::monotonic();
+}
+
+void Server::closeConnection(int fd)
+{
+    close(fd);
+    FD_CLR(fd, &master_set);
+    FD_CLR(fd, &write_set);
+
+    std::map<int, Connection>::iterator it = connections.find(fd);
+    if (it != connections.end())
+    {
+        rateLimiter.releaseConnection(it->second.remoteAddress);
+        Metrics::getInstance().increment(Metrics::CONNECTIONS_CLOSED);
+        delete it->second.multipart;
+        delete it->second.rawUpload;
+        connections.erase(it);
+    }
+}
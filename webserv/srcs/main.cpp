@@ -1,73 +1,108 @@
 #include <csignal>
+#include <sys/time.h>
 
 #include "../includes/Server.hpp"
 
-std::vector<int> openSockets;
-std::vector<ServerConfig> serverConfigs;
-
-bool isRunning = true;
-
-void cleanup(int signum)
+// Les signaux d'arrêt, de rechargement, de réouverture des journaux et de mise à jour sont traités par la boucle du serveur, réveillée via son self-pipe
+void setupSignalHandlers()
 {
+    struct sigaction sa;
 
-    for (size_t i = 0; i < openSockets.size(); ++i)
-    {
-        if (close(openSockets[i]) == -1)
-        {
-            std::cerr << "Erreur lors de la fermeture du descripteur de fichier " << openSockets[i] << std::endl;
-        }
-    }
-    openSockets.clear();
-    serverConfigs.clear();
+    sa.sa_handler = Server::notifySignal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
 
-    Logger::getInstance().cleanup();
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGHUP, &sa, NULL);
+    sigaction(SIGUSR1, &sa, NULL);
+    sigaction(SIGUSR2, &sa, NULL);
 
-    exit(signum);
+    signal(SIGPIPE, SIG_IGN);
 }
 
-void handleSignal(int signum)
+// "webserv -t config" : analyse la configuration et résout chaque adresse d'écoute, sans rien lier.
+// Le fichier journal n'est ni créé ni ouvert : avertissements et résultat sont écrits sur la sortie d'erreur
+int testConfiguration(const std::string& configFilePath)
 {
-    switch (signum)
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+
+    Logger::getInstance().setConsoleFd(STDERR_FILENO);
+    try
     {
-        case SIGINT:
-        case SIGTERM:
-            std::cout << "\r" << "Signal de terminaison reçu. Arrêt du serveur..." << std::endl;
-            isRunning = false;
-            cleanup(signum);
-            break;
-    }
-}
-void setupSignalHandlers()
-{
-    struct sigaction sa;
+        ConfigParser parser(configFilePath);
+        parser.parse();
 
-    sa.sa_handler = handleSignal;
-    sigemptyset(&sa.sa_mask);
-    sa.sa_flags = 0;
+        const std::vector<ServerConfig>& servers = parser.getServers();
+        for (size_t i = 0; i < servers.size(); ++i)
+        {
+            Listener listener;
+            if (!listener.resolve(servers[i].host, servers[i].port))
+            {
+                std::ostringstream msg;
+                msg << "bloc 'server' #" << (i + 1) << " : adresse d'écoute invalide " << servers[i].host << ":" << servers[i].port;
+                throw std::runtime_error(msg.str());
+            }
+        }
 
-    sigaction(SIGINT, &sa, NULL);
-    sigaction(SIGTERM, &sa, NULL);
+        gettimeofday(&end, NULL);
+        double elapsed = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+        std::cerr << configFilePath << " : configuration valide" << std::endl;
+        std::cerr << servers.size() << " bloc(s) server, " << parser.getLocationConfigs().size()
+                  << " location(s) analysés en " << elapsed << " ms" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << configFilePath << " : configuration invalide" << std::endl;
+        std::cerr << e.what() << std::endl;
+        Logger::getInstance().cleanup();
+        return 1;
+    }
 
-    signal(SIGPIPE, SIG_IGN);
+    Logger::getInstance().cleanup();
+    return 0;
 }
 
 int main(int argc, char *argv[])
 {
-    setupSignalHandlers();
+    std::string logFilePath = "server.log";
+    Logger::Level logLevel = Logger::INFO;
+
+    if (argc == 3 && std::string(argv[1]) == "-t")
+    {
+        return testConfiguration(argv[2]);
+    }
 
     if (argc != 2)
     {
-        std::cerr << "Usage: " << argv[0] << " <config_file_path>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " [-t] <config_file_path>" << std::endl;
         return 1;
     }
 
+    // Le self-pipe doit exister avant les gestionnaires : un SIGINT reçu pendant l'analyse ou le bind n'est pas perdu
+    if (!Server::openSignalPipe())
+    {
+        std::cerr << "Erreur : impossible de créer le pipe des signaux." << std::endl;
+        return 1;
+    }
+    setupSignalHandlers();
+
     std::string configFilePath = argv[1];
-    std::string logFilePath = "server.log";
-    Logger::Level logLevel = Logger::INFO;
 
-    Server httpServer(configFilePath, logFilePath, logLevel);
-    httpServer.start();
+    try
+    {
+        Server httpServer(configFilePath, logFilePath, logLevel);
+        httpServer.setExecutable(argv[0]);
+        httpServer.start();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Erreur : " << e.what() << std::endl;
+        Logger::getInstance().cleanup();
+        return 1;
+    }
 
+    Logger::getInstance().cleanup();
     return 0;
 }
-
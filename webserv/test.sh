@@ -62,6 +62,21 @@ perform_index_test() {
     fi
 }
 
+# Fonction pour effectuer un test avec un code de statut attendu
+perform_expected_test() {
+    local expected_status=$1
+    shift
+    status=$(curl -s -o /dev/null -w "%{http_code}" "$@")
+
+    echo -n "Test: $@ - Code attendu: $expected_status, Code obtenu: $status - "
+
+    if [ "$status" -eq "$expected_status" ]; then
+        echo -e "${GREEN}Réussi${NC}"
+    else
+        echo -e "${RED}Échec${NC}"
+    fi
+}
+
 # Fonction pour vérifier le contenu de la réponse
 check_response_content() {
     local url=$1
@@ -161,7 +176,12 @@ test_persistence() {
 echo -e "${YELLOW}Test du site statique sur le port 3000${NC}"
 perform_test -X GET localhost:3000/proxygirls.html
 perform_test -X POST localhost:3000 -d "data=test"
-perform_test -X POST localhost:3000 -d "@largefile.txt"
+perform_expected_test 413 -X POST localhost:3000 -d "@www/largefile.txt"
+perform_expected_test 413 -X POST -H "Transfer-Encoding: chunked" localhost:3000 -d "@www/largefile.txt"
+perform_test -X POST -F "fichier=@www/fichiers/FormulaireBasique.pdf" localhost:3000
+perform_test -X POST -H "Transfer-Encoding: chunked" -F "fichier=@www/fichiers/FormulaireBasique.pdf" localhost:3000
+perform_test -X POST -H "Transfer-Encoding: chunked" localhost:3000 -d "data=test"
+rm -f uploads/FormulaireBasique.pdf
 perform_test -X DELETE localhost:3000/delete.txt
 perform_test -X DELETE localhost:3500/delete2.txt
 
@@ -200,6 +220,17 @@ echo -e "${YELLOW}\nDébut des tests de persistance de session sur les ports 350
 test_persistence $SERVER_URL_3500 3500
 test_persistence $SERVER_URL_3000 3000
 
+# Filtrage par adresse sur le port 4600 : le bloc par défaut refuse le client (403), cidr.localhost l'autorise
+echo -e "${YELLOW}\nTests de filtrage par adresse sur le port 4600${NC}"
+perform_expected_test 200 -H "Host: cidr.localhost" localhost:4600/
+perform_expected_test 403 -H "Host: refuse.localhost" localhost:4600/
+perform_expected_test 403 localhost:4600/
+
+# Limitation de débit : limite.localhost n'accepte qu'une requête par seconde, la seconde reçoit 429
+echo -e "${YELLOW}\nTest de limitation de débit sur le port 4600${NC}"
+curl -s -o /dev/null -H "Host: limite.localhost" localhost:4600/
+perform_expected_test 429 -H "Host: limite.localhost" localhost:4600/
+
 # Test de charge avec siege
 echo -e "${YELLOW}\nLancement du test de charge avec siege${NC}"
 # Récupération du résultat de siege